@@ -0,0 +1,297 @@
+/** @file example/nbody/BarnesHut.h
+ *
+ * @brief Barnes-Hut octree for the nbody simulation example
+ *
+ * For copyright and license information, see the end of the file.
+ */
+#ifndef BARNESHUT_H
+#define BARNESHUT_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "SOAContainer.h"
+#include "SOAAlgorithms.h"
+#include "NBody.h"
+
+namespace BHNode
+{
+    // centre of mass (sum of m * x while the tree is being built)
+    SOAFIELD_TRIVIAL(cx, cx, float);
+    SOAFIELD_TRIVIAL(cy, cy, float);
+    SOAFIELD_TRIVIAL(cz, cz, float);
+    // total mass
+    SOAFIELD_TRIVIAL(m, m, float);
+    // geometric centre of the cell, and half its edge length
+    SOAFIELD_TRIVIAL(x0, x0, float);
+    SOAFIELD_TRIVIAL(y0, y0, float);
+    SOAFIELD_TRIVIAL(z0, z0, float);
+    SOAFIELD_TRIVIAL(half, half, float);
+    // index of the first of eight children (0: leaf)
+    SOAFIELD_TRIVIAL(child, child, int32_t);
+    // particle in leaf (see Octree::empty and Octree::several)
+    SOAFIELD_TRIVIAL(body, body, int32_t);
+
+    SOASKIN(Skin, cx, cy, cz, m, x0, y0, z0, half, child, body) {
+	SOASKIN_INHERIT_DEFAULT_METHODS(Skin);
+
+	bool leaf() const noexcept { return !this->child(); }
+
+	/// octant of the cell that contains (x, y, z)
+	int octant(float x, float y, float z) const noexcept
+	{
+	    return (x >= this->x0()) | ((y >= this->y0()) << 1) |
+		((z >= this->z0()) << 2);
+	}
+    };
+}
+
+typedef SOA::Container<std::vector, BHNode::Skin> BHNodes;
+
+/** @brief Barnes-Hut octree over a set of mass points
+ *
+ * The nodes of the tree are stored in a SOA container; the eight children
+ * of a node are stored next to each other, so a node only needs to know
+ * where its first child is. Cells are opened during the tree walk if
+ * their size is larger than the opening angle times the distance to
+ * their centre of mass; cells which contain the particle being kicked
+ * are always opened, and its own mass is taken out of its leaf, so
+ * particles never feel a force from themselves.
+ */
+class Octree
+{
+    public:
+	enum : int32_t {
+	    /// leaf without particle
+	    empty = -1,
+	    /// leaf at maximum depth with more than one particle
+	    several = -2
+	};
+	/// maximum depth of the tree
+	static constexpr unsigned maxdepth = 32;
+
+	/// constructor
+	Octree(float theta = 0.5f) : m_theta2(theta * theta) {}
+
+	/// number of nodes in the tree
+	std::size_t size() const noexcept { return m_nodes.size(); }
+	/// nodes of the tree
+	const BHNodes& nodes() const noexcept { return m_nodes; }
+
+	/// (re)build the tree for the mass points in pts
+	template <typename MASSPOINTS>
+	void build(const MASSPOINTS& pts);
+
+	/** @brief kick particles by the force from all others
+	 *
+	 * Each particle's momentum changes by Gdt m M d / (|dx|^3 + |dy|^3 +
+	 * |dz|^3) for each (pseudo-)particle of mass M at distance d
+	 * (dx, dy, dz), the same force law as in NBody::kick.
+	 */
+	template <typename MASSPOINTS>
+	void kick(MASSPOINTS& pts, float Gdt) const noexcept;
+
+    private:
+	BHNodes m_nodes;
+	float m_theta2;
+
+	/// add mass m at (x, y, z) to node
+	void add_mass(std::size_t node, float x, float y, float z,
+		float m) noexcept
+	{
+	    auto n = m_nodes[node];
+	    n.cx() += m * x, n.cy() += m * y, n.cz() += m * z, n.m() += m;
+	}
+
+	/// give node eight (empty) children
+	void split(std::size_t node)
+	{
+	    const float h = m_nodes[node].half() / 2;
+	    const float x0 = m_nodes[node].x0(), y0 = m_nodes[node].y0(),
+		  z0 = m_nodes[node].z0();
+	    m_nodes[node].child() = m_nodes.size();
+	    for (int oct = 0; oct < 8; ++oct) {
+		m_nodes.emplace_back(0.f, 0.f, 0.f, 0.f,
+			(oct & 1) ? x0 + h : x0 - h,
+			(oct & 2) ? y0 + h : y0 - h,
+			(oct & 4) ? z0 + h : z0 - h, h, 0, empty);
+	    }
+	}
+
+	/// insert particle i into the tree
+	template <typename MASSPOINTS>
+	void insert(const MASSPOINTS& pts, int32_t i);
+};
+
+template <typename MASSPOINTS>
+void Octree::build(const MASSPOINTS& pts)
+{
+    m_nodes.clear();
+    if (pts.empty()) return;
+    m_nodes.reserve(2 * pts.size());
+    // bounding cube of all particles
+    float lo[3] = { std::numeric_limits<float>::max(),
+	std::numeric_limits<float>::max(),
+	std::numeric_limits<float>::max() };
+    float hi[3] = { std::numeric_limits<float>::lowest(),
+	std::numeric_limits<float>::lowest(),
+	std::numeric_limits<float>::lowest() };
+    for (typename MASSPOINTS::const_reference p: pts) {
+	lo[0] = std::min(lo[0], p.x()), hi[0] = std::max(hi[0], p.x());
+	lo[1] = std::min(lo[1], p.y()), hi[1] = std::max(hi[1], p.y());
+	lo[2] = std::min(lo[2], p.z()), hi[2] = std::max(hi[2], p.z());
+    }
+    const float half = 0.5f * std::max({ hi[0] - lo[0], hi[1] - lo[1],
+	    hi[2] - lo[2], std::numeric_limits<float>::min() }) * 1.0001f;
+    m_nodes.emplace_back(0.f, 0.f, 0.f, 0.f, 0.5f * (lo[0] + hi[0]),
+	    0.5f * (lo[1] + hi[1]), 0.5f * (lo[2] + hi[2]), half, 0, empty);
+    for (int32_t i = 0, n = pts.size(); i < n; ++i) insert(pts, i);
+    // turn sums of m * x into centres of mass
+    SOA::for_each(m_nodes, [] (SOA::ref<BHNode::cx> x, SOA::ref<BHNode::cy> y,
+		SOA::ref<BHNode::cz> z, SOA::cref<BHNode::m> m) {
+	    const float minv = (m > 0.f) ? 1.f / m : 0.f;
+	    x *= minv, y *= minv, z *= minv;
+	    });
+}
+
+template <typename MASSPOINTS>
+void Octree::insert(const MASSPOINTS& pts, int32_t i)
+{
+    auto&& p = pts[i];
+    std::size_t node = 0;
+    for (unsigned depth = 0; ; ++depth) {
+	add_mass(node, p.x(), p.y(), p.z(), p.m());
+	if (!m_nodes[node].leaf()) {
+	    node = m_nodes[node].child() +
+		m_nodes[node].octant(p.x(), p.y(), p.z());
+	    continue;
+	}
+	const int32_t other = m_nodes[node].body();
+	if (empty == other) {
+	    m_nodes[node].body() = i;
+	    return;
+	}
+	if (several == other || depth >= maxdepth) {
+	    // (nearly) coincident particles: keep them together
+	    m_nodes[node].body() = several;
+	    return;
+	}
+	// leaf with one particle: move that one down one level, then try
+	// again with particle i
+	split(node);
+	m_nodes[node].body() = empty;
+	auto&& q = pts[other];
+	const std::size_t c = m_nodes[node].child() +
+	    m_nodes[node].octant(q.x(), q.y(), q.z());
+	add_mass(c, q.x(), q.y(), q.z(), q.m());
+	m_nodes[c].body() = other;
+	node = m_nodes[node].child() +
+	    m_nodes[node].octant(p.x(), p.y(), p.z());
+    }
+}
+
+template <typename MASSPOINTS>
+void Octree::kick(MASSPOINTS& pts, float Gdt) const noexcept
+{
+    if (m_nodes.empty()) return;
+    std::array<int32_t, 8 * (maxdepth + 1)> stack;
+    // does the cell on the stack contain the particle being kicked?
+    std::array<bool, 8 * (maxdepth + 1)> own;
+    for (int32_t i = 0, n = pts.size(); i < n; ++i) {
+	auto&& p = pts[i];
+	const float x = p.x(), y = p.y(), z = p.z(), mi = p.m();
+	float dpx = 0.f, dpy = 0.f, dpz = 0.f;
+	std::size_t sp = 0;
+	stack[sp] = 0, own[sp++] = true;
+	while (sp) {
+	    const auto nd = m_nodes[stack[--sp]];
+	    const bool mine = own[sp];
+	    if (nd.m() <= 0.f) continue;
+	    float m = nd.m(), dx = nd.cx() - x, dy = nd.cy() - y,
+		  dz = nd.cz() - z;
+	    if (!nd.leaf()) {
+		const float s = 2 * nd.half();
+		const float r2 = dx * dx + dy * dy + dz * dz;
+		if (mine || s * s >= m_theta2 * r2) {
+		    // too close, or particle i inside: look at the children
+		    const int32_t home = mine ?
+			nd.child() + nd.octant(x, y, z) : -1;
+		    for (int32_t c = nd.child(), ce = c + 8; c != ce; ++c)
+			stack[sp] = c, own[sp++] = (c == home);
+		    continue;
+		}
+	    } else if (mine) {
+		// leaf with particle i (and maybe others): take out i's own
+		// mass, the centre of mass of the rest is m / (m - mi) times
+		// further away
+		const float mrest = m - mi;
+		if (mrest <= 0.f) continue;
+		const float f = m / mrest;
+		dx *= f, dy *= f, dz *= f, m = mrest;
+	    }
+	    const float ax = std::abs(dx), ay = std::abs(dy),
+		  az = std::abs(dz);
+	    const float r3 = ax * ax * ax + ay * ay * ay + az * az * az;
+	    if (r3 <= 0.f) continue;
+	    const float k = m / r3;
+	    dpx += k * dx, dpy += k * dy, dpz += k * dz;
+	}
+	const float gm = Gdt * mi;
+	p.px() += gm * dpx, p.py() += gm * dpy, p.pz() += gm * dpz;
+    }
+}
+
+/// nbody simulation using a Barnes-Hut octree for the kicks
+template <typename MASSPOINTS>
+class BarnesHutNBody : public NBody<MASSPOINTS>
+{
+    protected:
+	Octree tree;
+
+	void kick(float dt) __attribute__((noinline))
+	{
+	    tree.build(this->allpoints);
+	    tree.kick(this->allpoints, this->G * dt);
+	}
+
+    public:
+	/// constructor (theta is the opening angle)
+	BarnesHutNBody(unsigned N = 1 << 10, float theta = 0.5f) :
+	    NBody<MASSPOINTS>(N), tree(theta)
+	{}
+
+	// integrate equations of motion by making small time steps dt (use
+	// leapfrog method which is very stable)
+	bool iterate()
+	{
+	    this->drift(this->dt / 2);
+	    kick(this->dt);
+	    this->drift(this->dt / 2);
+	    return true;
+	}
+};
+
+/* Copyright (C) CERN for the benefit of the LHCb collaboration
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In applying this licence, CERN does not waive the privileges and immunities
+ * granted to it by virtue of its status as an Intergovernmental Organization
+ * or submit itself to any jurisdiction.
+ */
+
+#endif // BARNESHUT_H
@@ -17,6 +17,7 @@
 using namespace std;
 
 #include "SOAContainer.h"
+#include "SOAAoSoAStorage.h"
 
 namespace SOAMPoint
 {
@@ -49,6 +50,8 @@ namespace SOAMPoint
 
 
 typedef SOA::Container<std::vector, SOAMPoint::Skin> SOAMPoints;
+/// tiled layout: blocks of 8 particles, all fields of a block together
+typedef SOA::Container<SOA::AoSoA<8>::storage, SOAMPoint::Skin> AoSoAMPoints;
 
 /* Copyright (C) CERN for the benefit of the LHCb collaboration
  *
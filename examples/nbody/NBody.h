@@ -8,6 +8,9 @@
  *
  * For copyright and license information, see the end of the file.
  */
+#ifndef NBODY_H
+#define NBODY_H
+
 #include <iostream>
 #include <vector>
 #include <chrono>
@@ -16,6 +19,11 @@
 #include <cmath>
 #include <tuple>
 #include <array>
+#include <functional>
+#include <type_traits>
+
+#include "SOAAlgorithms.h"
+#include "MPointSOA.h"
 
 using namespace std;
 
@@ -29,22 +37,30 @@ class NBody
 	MASSPOINTS allpoints;
 	std::vector<float> vtmp0;
 
+	/// SoA containers go through SOA algorithms, AoS loops by hand
+	using is_soa = std::integral_constant<bool,
+	      SOA::Utils::is_view<MASSPOINTS>::value>;
+
 	void drift(float dt) noexcept __attribute__((noinline));
 	void kick(float dt) noexcept __attribute__((noinline));
+	void kick(float dt, std::false_type) noexcept;
+	void kick(float dt, std::true_type) noexcept;
 	void kick_help(typename MASSPOINTS::iterator begin, typename MASSPOINTS::iterator end, float dt) noexcept __attribute__((noinline));
 
-    public:
-	/// return total mass of system
-	float M() const noexcept
+	float M(std::false_type) const noexcept
 	{
 	    float retVal = 0;
 	    for (typename MASSPOINTS::const_reference p: allpoints)
 	       	retVal += p.m();
 	    return retVal;
 	}
+	float M(std::true_type) const noexcept
+	{
+	    return SOA::transform_reduce(allpoints, 0.f, std::plus<float>(),
+		    [] (SOA::cref<SOAMPoint::m> m) { return float(m); });
+	}
 
-	/// return kinetic energy of system
-	float Ekin() const noexcept
+	float Ekin(std::false_type) const noexcept
 	{
 	    float retVal = 0;
 	    for (typename MASSPOINTS::const_reference p: allpoints) {
@@ -53,9 +69,16 @@ class NBody
 	    }
 	    return retVal / 2;
 	}
+	float Ekin(std::true_type) const noexcept
+	{
+	    return SOA::transform_reduce(allpoints, 0.f, std::plus<float>(),
+		    [] (SOA::cref<SOAMPoint::px> px, SOA::cref<SOAMPoint::py> py,
+			SOA::cref<SOAMPoint::pz> pz, SOA::cref<SOAMPoint::m> m) {
+		    return (px * px + py * py + pz * pz) / m;
+		    }) / 2;
+	}
 
-	/// return centre-of-mass momentum
-	std::tuple<float, float, float> pcms() const noexcept
+	std::tuple<float, float, float> pcms(std::false_type) const noexcept
 	{
 	    float px = 0, py = 0, pz = 0;
 	    for (typename MASSPOINTS::const_reference p: allpoints) {
@@ -63,9 +86,17 @@ class NBody
 	    }
 	    return std::make_tuple(px, py, pz);
 	}
+	std::tuple<float, float, float> pcms(std::true_type) const noexcept
+	{
+	    return SOA::transform_reduce(allpoints,
+		    std::make_tuple(0.f, 0.f, 0.f), SOA::elementwise_plus(),
+		    [] (SOA::cref<SOAMPoint::px> px, SOA::cref<SOAMPoint::py> py,
+			SOA::cref<SOAMPoint::pz> pz) {
+		    return std::make_tuple(float(px), float(py), float(pz));
+		    });
+	}
 
-	/// return centre-of-mass position
-	std::tuple<float, float, float> cms() const noexcept
+	std::tuple<float, float, float> cms(std::false_type) const noexcept
 	{
 	    float x = 0, y = 0, z = 0, m = 0;
 	    for (typename MASSPOINTS::const_reference p: allpoints) {
@@ -74,9 +105,20 @@ class NBody
 	    }
 	    return std::make_tuple(x / m, y / m, z / m);
 	}
+	std::tuple<float, float, float> cms(std::true_type) const noexcept
+	{
+	    const auto r = SOA::transform_reduce(allpoints,
+		    std::make_tuple(0.f, 0.f, 0.f, 0.f), SOA::elementwise_plus(),
+		    [] (SOA::cref<SOAMPoint::x> x, SOA::cref<SOAMPoint::y> y,
+			SOA::cref<SOAMPoint::z> z, SOA::cref<SOAMPoint::m> m) {
+		    return std::make_tuple(x * m, y * m, z * m, float(m));
+		    });
+	    const float m = std::get<3>(r);
+	    return std::make_tuple(std::get<0>(r) / m, std::get<1>(r) / m,
+		    std::get<2>(r) / m);
+	}
 
-	/// return total angular momentum
-	std::tuple<float, float, float> Ltot() const noexcept
+	std::tuple<float, float, float> Ltot(std::false_type) const noexcept
 	{
 	    float lx = 0, ly = 0, lz = 0;
 	    for (typename MASSPOINTS::const_reference p: allpoints) {
@@ -86,6 +128,37 @@ class NBody
 	    }
 	    return std::make_tuple(lx, ly, lz);
 	}
+	std::tuple<float, float, float> Ltot(std::true_type) const noexcept
+	{
+	    return SOA::transform_reduce(allpoints,
+		    std::make_tuple(0.f, 0.f, 0.f), SOA::elementwise_plus(),
+		    [] (SOA::cref<SOAMPoint::x> x, SOA::cref<SOAMPoint::y> y,
+			SOA::cref<SOAMPoint::z> z, SOA::cref<SOAMPoint::px> px,
+			SOA::cref<SOAMPoint::py> py,
+			SOA::cref<SOAMPoint::pz> pz) {
+		    return std::make_tuple(y * pz - z * py, z * px - x * pz,
+			    x * py - y * px);
+		    });
+	}
+
+    public:
+	/// return total mass of system
+	float M() const noexcept { return M(is_soa()); }
+
+	/// return kinetic energy of system
+	float Ekin() const noexcept { return Ekin(is_soa()); }
+
+	/// return centre-of-mass momentum
+	std::tuple<float, float, float> pcms() const noexcept
+	{ return pcms(is_soa()); }
+
+	/// return centre-of-mass position
+	std::tuple<float, float, float> cms() const noexcept
+	{ return cms(is_soa()); }
+
+	/// return total angular momentum
+	std::tuple<float, float, float> Ltot() const noexcept
+	{ return Ltot(is_soa()); }
 
 	/// return kinetic energy of system
 	float Epot() const noexcept
@@ -198,12 +271,45 @@ void NBody<MASSPOINTS>::kick_help(typename MASSPOINTS::iterator begin,
 #endif
 template <typename MASSPOINTS>
 void NBody<MASSPOINTS>::kick(float dt) noexcept
+{
+    kick(dt, is_soa());
+}
+
+template <typename MASSPOINTS>
+void NBody<MASSPOINTS>::kick(float dt, std::false_type) noexcept
 {
     for (auto it = allpoints.end(), ite = allpoints.begin(); ite != it--; ) {
 	kick_help(ite, it, dt);
     }
 }
 
+/// pairwise kick for SoA containers (same force law as kick_help)
+struct NBodyKick {
+    float gdt;
+    void operator()(SOA::cref<SOAMPoint::x> xi, SOA::cref<SOAMPoint::y> yi,
+	    SOA::cref<SOAMPoint::z> zi, SOA::cref<SOAMPoint::m> mi,
+	    SOA::ref<SOAMPoint::px> pxi, SOA::ref<SOAMPoint::py> pyi,
+	    SOA::ref<SOAMPoint::pz> pzi,
+	    SOA::cref<SOAMPoint::x> xj, SOA::cref<SOAMPoint::y> yj,
+	    SOA::cref<SOAMPoint::z> zj, SOA::cref<SOAMPoint::m> mj,
+	    SOA::ref<SOAMPoint::px> pxj, SOA::ref<SOAMPoint::py> pyj,
+	    SOA::ref<SOAMPoint::pz> pzj) const noexcept
+    {
+	const float dx = xj - xi, dy = yj - yi, dz = zj - zi;
+	const float ax = std::abs(dx), ay = std::abs(dy), az = std::abs(dz);
+	const float k = gdt * mi * mj / (ax * ax * ax + ay * ay * ay +
+		az * az * az);
+	pxi += dx * k, pyi += dy * k, pzi += dz * k;
+	pxj -= dx * k, pyj -= dy * k, pzj -= dz * k;
+    }
+};
+
+template <typename MASSPOINTS>
+void NBody<MASSPOINTS>::kick(float dt, std::true_type) noexcept
+{
+    SOA::for_each_unique_pair(allpoints, NBodyKick{G * dt});
+}
+
 template <typename MASSPOINTS>
 std::ostream& operator<<(std::ostream& os, const NBody<MASSPOINTS>& sim)
 {
@@ -340,3 +446,5 @@ NBody<MASSPOINTS>::~NBody()
  * granted to it by virtue of its status as an Intergovernmental Organization
  * or submit itself to any jurisdiction.
  */
+
+#endif // NBODY_H
@@ -16,18 +16,19 @@
 #include <cmath>
 
 #include "NBody.h"
+#include "BarnesHut.h"
 #include "MPoint.h"
 #include "MPointSOA.h"
 
 using namespace std;
 
-template <typename MPOINTS>
+template <typename MPOINTS, template <typename> class SIM = NBody>
 void benchmark()
 {
     using MassPoints = MPOINTS;
 
     auto t1 = chrono::high_resolution_clock::now();
-    NBody<MassPoints> sim(1 << 12);
+    SIM<MassPoints> sim(1 << 12);
     auto t2 = chrono::high_resolution_clock::now();
     cout << "Initialization done ";
     cout << chrono::duration_cast<chrono::nanoseconds>(t2 - t1).count() << " ns\n";
@@ -46,6 +47,11 @@ int main(int /* argc */, char * /* argv */ [])
     benchmark<MPoints>();
     std::cout << std::endl << "Running SOA code:" << std::endl;
     benchmark<SOAMPoints>();
+    std::cout << std::endl << "Running AoSoA code:" << std::endl;
+    benchmark<AoSoAMPoints>();
+    std::cout << std::endl << "Running SOA code (Barnes-Hut octree):" <<
+	std::endl;
+    benchmark<SOAMPoints, BarnesHutNBody>();
     return 0;
 }
 
@@ -13,8 +13,15 @@
 #define ALIGNEDALLOCATOR_H
 
 #include <limits>
+#include <new>
+#include <type_traits>
 
 namespace SOA {
+    /// tag to request default- (rather than value-) initialisation
+    struct default_init_t {};
+    /// tag to request default- (rather than value-) initialisation
+    constexpr default_init_t default_init{};
+
     /** @brief aligned allocator
      *
      * @author Manuel Schiller <Manuel.Schiller@glasgow.ac.uk>
@@ -113,6 +120,14 @@ namespace SOA {
         {
             return std::numeric_limits<size_type>::max() / sizeof(T);
         }
+        /// default-initialise (i.e. leave trivial types uninitialised)
+        template <typename U>
+        void construct(U* p, default_init_t) const noexcept(
+                noexcept(U()))
+        {
+            ::new (static_cast<void*>(p)) U;
+        }
+
         constexpr bool operator==(const AlignedAllocator<T, ALIGN>&) const
                 noexcept
         {
@@ -152,6 +167,18 @@ namespace SOA {
     /// convenience typedef for 64 byte alignment
     template <typename T>
     using CacheLineAlignedAllocator = AlignedAllocator<T, 64>;
+
+    /** @brief can ALLOC construct elements from SOA::default_init?
+     *
+     * Specialise for other allocators which provide
+     * construct(T*, SOA::default_init_t).
+     */
+    template <typename ALLOC>
+    struct allocator_default_inits : std::false_type {};
+    /// AlignedAllocator does
+    template <typename T, std::size_t ALIGN>
+    struct allocator_default_inits<AlignedAllocator<T, ALIGN> >
+            : std::true_type {};
 } // namespace SOA
 
 #endif // ALIGNEDALLOCATOR_H
@@ -7,8 +7,18 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
 #include <type_traits>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "c++14_compat.h"
@@ -18,6 +28,33 @@
 #include "SOATaggedType.h"
 #include "SOAContainer.h"
 
+#ifndef SOA_PREFETCH
+#ifdef __GNUC__
+/// prefetch addr for reading (rw = 0) or writing (rw = 1)
+#define SOA_PREFETCH(addr, rw) __builtin_prefetch((addr), (rw))
+#else // __GNUC__
+#define SOA_PREFETCH(addr, rw) ((void) 0)
+#endif // __GNUC__
+#endif // SOA_PREFETCH
+
+#ifndef SOA_RESTRICT
+#if defined(__GNUC__) || defined(_MSC_VER)
+/// pointer does not alias other pointers (no-alias hint for raw loops)
+#define SOA_RESTRICT __restrict
+#else // __GNUC__ || _MSC_VER
+#define SOA_RESTRICT
+#endif // __GNUC__ || _MSC_VER
+#endif // SOA_RESTRICT
+
+#ifndef SOA_ASSUME_ALIGNED
+#ifdef __GNUC__
+/// tell the compiler that pointer p is aligned to a bytes
+#define SOA_ASSUME_ALIGNED(p, a) __builtin_assume_aligned((p), (a))
+#else // __GNUC__
+#define SOA_ASSUME_ALIGNED(p, a) (p)
+#endif // __GNUC__
+#endif // SOA_ASSUME_ALIGNED
+
 namespace SOA {
     /// namespace with SOA algorithm implementation details
     namespace impl_algs {
@@ -201,41 +238,231 @@ namespace SOA {
             }
         };
 
-        /// helper for transform
-        template <template <class> class SKIN,
-                  template <class...> class CONTAINER, typename VIEW,
-                  typename FUNC, std::size_t... IDXS, typename... ARGS,
+        /// can C be resized without initialising new elements?
+        template <typename C, typename = void>
+        struct can_resize_default_init : std::false_type {};
+        /// can C be resized without initialising new elements?
+        template <typename C>
+        struct can_resize_default_init<
+                C, std::void_t<typename C::can_resize_default_init> >
+                : C::can_resize_default_init {};
+        /// size new container without initialising trivial fields
+        template <typename C>
+        void resize_for_overwrite(C& c, typename C::size_type sz,
+                                  std::true_type /* default init ok */)
+        { c.resize_default_init(sz); }
+        /// size new container
+        template <typename C>
+        void resize_for_overwrite(C& c, typename C::size_type sz,
+                                  std::false_type /* default init ok */)
+        { c.resize(sz); }
+        /// size new container, leaving new elements uninitialised if
+        /// possible
+        template <typename C>
+        void resize_for_overwrite(C& c, typename C::size_type sz)
+        { resize_for_overwrite(c, sz, can_resize_default_init<C>()); }
+        /// can all fields of a view be default-constructed?
+        template <typename TL>
+        struct all_fields_default_constructible;
+        template <typename... FIELDS>
+        struct all_fields_default_constructible<
+                SOA::Typelist::typelist<FIELDS...> >
+                : std::integral_constant<
+                          bool, SOA::Utils::ALL(
+                                        std::is_default_constructible<
+                                                SOA::Typelist::unwrap_t<
+                                                        FIELDS> >::
+                                                value...)> {};
+
+        /// start of a column: raw pointer if contiguous, iterator otherwise
+        template <typename IT>
+        auto column_start(IT it, std::true_type /* contiguous */)
+                -> decltype(&*it)
+        { return &*it; }
+        template <typename IT>
+        IT column_start(IT it, std::false_type /* contiguous */)
+        { return it; }
+        template <typename IT>
+        auto column_start(IT it) -> decltype(column_start(
+                it, SOA::impl::is_contiguous_iterator<IT>()))
+        { return column_start(it, SOA::impl::is_contiguous_iterator<IT>()); }
+
+        /// can a loop run over raw pointers, one contiguous run at a time?
+        template <typename... ITS>
+        struct segmented_loop_ok
+                : std::integral_constant<
+                          bool,
+                          SOA::Utils::ALL((
+                                  SOA::impl::is_contiguous_iterator<
+                                          ITS>::value ||
+                                  SOA::impl::is_segmented_iterator<
+                                          ITS>::value)...) &&
+                                  SOA::Utils::ANY(
+                                          SOA::impl::is_segmented_iterator<
+                                                  ITS>::value...)> {};
+        /// number of rows (at most n) contiguous in memory in all columns
+        inline std::size_t common_run(std::size_t n) noexcept { return n; }
+        template <typename IT, typename... ITS>
+        std::size_t common_run(std::size_t n, const IT& it,
+                               const ITS&... its) noexcept
+        {
+            const std::size_t run = SOA::impl::contiguous_run(it);
+            return common_run(run < n ? run : n, its...);
+        }
+
+        /// write functor result (tuple of tagged values) to row i of outs
+        template <typename OUTS, std::size_t... OUTIDXS, typename... RS>
+        void store_result(std::index_sequence<OUTIDXS...> /* unused */,
+                          OUTS& outs, std::size_t i, std::tuple<RS...>&& r)
+        {
+            nop((std::get<OUTIDXS>(outs)[i] =
+                         std::get<0>(std::move(std::get<OUTIDXS>(r))),
+                 0)...);
+        }
+        /// write functor result (single tagged value) to row i of outs
+        template <typename OUTS, typename R>
+        typename std::enable_if<SOA::is_tagged_type<
+                typename std::decay<R>::type>::value>::type
+        store_result(std::index_sequence<0> /* unused */, OUTS& outs,
+                     std::size_t i, R&& r)
+        { std::get<0>(outs)[i] = std::get<0>(std::move(r)); }
+
+        /// loop for transform: contiguous columns or general iterators
+        template <typename INS, typename OUTS, typename FUNC,
+                  std::size_t... IDXS, typename... ARGS,
+                  std::size_t... OUTIDXS>
+        void transform_loop(std::index_sequence<IDXS...> /* unused */,
+                            SOA::Typelist::typelist<ARGS...> /* unused */,
+                            std::index_sequence<OUTIDXS...> outseq,
+                            std::size_t n, const INS& ins, const OUTS& outs,
+                            FUNC& func, std::false_type /* segmented */)
+        {
+            const auto pin =
+                    std::make_tuple(column_start(std::get<IDXS>(ins))...);
+            auto pout = std::make_tuple(
+                    column_start(std::get<OUTIDXS>(outs))...);
+            for (std::size_t i = 0; i < n; ++i) {
+                store_result(outseq, pout, i,
+                             func(ARGS(std::get<IDXS>(pin)[i])...));
+            }
+        }
+        /// loop for transform: raw pointers, one contiguous run at a time
+        template <typename INS, typename OUTS, typename FUNC,
+                  std::size_t... IDXS, typename... ARGS,
+                  std::size_t... OUTIDXS>
+        void transform_loop(std::index_sequence<IDXS...> /* unused */,
+                            SOA::Typelist::typelist<ARGS...> /* unused */,
+                            std::index_sequence<OUTIDXS...> outseq,
+                            std::size_t n, const INS& ins, const OUTS& outs,
+                            FUNC& func, std::true_type /* segmented */)
+        {
+            INS in(ins);
+            OUTS out(outs);
+            for (std::size_t i = 0, len; i < n; i += len) {
+                len = common_run(n - i, std::get<IDXS>(in)...,
+                                 std::get<OUTIDXS>(out)...);
+                const auto pin = std::make_tuple(&*std::get<IDXS>(in)...);
+                auto pout = std::make_tuple(&*std::get<OUTIDXS>(out)...);
+                for (std::size_t j = 0; j < len; ++j) {
+                    store_result(outseq, pout, j,
+                                 func(ARGS(std::get<IDXS>(pin)[j])...));
+                }
+                nop((std::get<IDXS>(in) += len, 0)...,
+                    (std::get<OUTIDXS>(out) += len, 0)...);
+            }
+        }
+
+        /// transform into retVal by appending one element at a time
+        template <typename RETVAL, typename VIEW, typename FUNC,
+                  std::size_t... IDXS, typename... ARGS,
                   std::size_t... OUTIDXS, typename... OUTARGS>
-        SOA::Container<CONTAINER, SKIN, typename OUTARGS::field_type...>
-        __transform(std::index_sequence<IDXS...> /* unused */,
-                    SOA::Typelist::typelist<ARGS...> /* unused */,
-                    std::index_sequence<OUTIDXS...> /* unused */,
-                    SOA::Typelist::typelist<OUTARGS...> /* unused */,
-                    VIEW&& view, FUNC&& func)
+        void _transform_append(std::index_sequence<IDXS...> /* unused */,
+                               SOA::Typelist::typelist<ARGS...> /* unused */,
+                               std::index_sequence<OUTIDXS...> /* unused */,
+                               SOA::Typelist::typelist<OUTARGS...>
+                               /* unused */,
+                               RETVAL& retVal, VIEW& view, FUNC& func)
         {
-            SOA::Container<CONTAINER, SKIN, typename OUTARGS::field_type...>
-                    retVal;
-            reserve_if_possible<decltype(retVal)>(retVal, view.size());
+            reserve_if_possible<RETVAL>(retVal, view.size());
             auto its = std::make_tuple(
                     view.template begin<find_idx<
                             typename std::remove_reference<
                                     VIEW>::type::fields_typelist,
-                            typename std::remove_cv<
-                                    typename std::remove_reference<
-                                            ARGS>::type>::type>::value>()...);
-            const auto itEnd = std::get<0>(std::make_tuple(
-                    view.template end<find_idx<
-                            typename std::remove_reference<
-                                    VIEW>::type::fields_typelist,
-                            typename std::remove_cv<
-                                    typename std::remove_reference<ARGS>::
-                                            type>::type>::value>()...));
-            for (; itEnd != std::get<0>(its);
-                 nop((++std::get<IDXS>(its), 0)...)) {
+                            typename std::remove_cv<typename std::
+                                    remove_reference<ARGS>::type>::type>::
+                                    value>()...);
+            for (std::size_t i = 0, n = view.size(); i < n;
+                 ++i, nop((++std::get<IDXS>(its), 0)...)) {
                 std::tuple<OUTARGS...> result(
-                        std::forward<FUNC>(func)(ARGS(*std::get<IDXS>(its))...));
-                retVal.emplace_back(std::move(std::get<OUTIDXS>(result))...);
+                        func(ARGS(*std::get<IDXS>(its))...));
+                retVal.emplace_back(
+                        std::move(std::get<OUTIDXS>(result))...);
             }
+        }
+
+        /// transform into retVal: presize, then fill column by column
+        template <typename RETVAL, typename VIEW, typename FUNC,
+                  std::size_t... IDXS, typename... ARGS,
+                  std::size_t... OUTIDXS, typename... OUTARGS>
+        void _transform_into(std::index_sequence<IDXS...> /* unused */,
+                             SOA::Typelist::typelist<ARGS...> /* unused */,
+                             std::index_sequence<OUTIDXS...> outseq,
+                             SOA::Typelist::typelist<OUTARGS...>
+                             /* unused */,
+                             RETVAL& retVal, VIEW& view, FUNC& func,
+                             std::true_type /* default constructible */)
+        {
+            const std::size_t n = view.size();
+            if (!n) return;
+            // size output once, then write each field straight into its
+            // column
+            resize_for_overwrite(retVal, n);
+            const auto ins = std::make_tuple(
+                    view.template begin<find_idx<
+                            typename std::remove_reference<
+                                    VIEW>::type::fields_typelist,
+                            typename std::remove_cv<typename std::
+                                    remove_reference<ARGS>::type>::type>::
+                                    value>()...);
+            const auto outs = std::make_tuple(
+                    retVal.template begin<OUTIDXS>()...);
+            transform_loop(
+                    std::index_sequence<IDXS...>(),
+                    SOA::Typelist::typelist<ARGS...>(), outseq, n, ins,
+                    outs, func,
+                    segmented_loop_ok<
+                            typename std::tuple_element<
+                                    IDXS, decltype(ins)>::type...,
+                            typename std::tuple_element<
+                                    OUTIDXS, decltype(outs)>::type...>());
+        }
+        /// transform into retVal: output fields which cannot be presized
+        template <typename RETVAL, typename VIEW, typename FUNC,
+                  typename SEQ, typename TL, typename OUTSEQ,
+                  typename OUTTL>
+        void _transform_into(SEQ seq, TL tl, OUTSEQ outseq, OUTTL outtl,
+                             RETVAL& retVal, VIEW& view, FUNC& func,
+                             std::false_type /* default constructible */)
+        { _transform_append(seq, tl, outseq, outtl, retVal, view, func); }
+
+        /// helper for transform
+        template <template <class> class SKIN,
+                  template <class...> class CONTAINER, typename VIEW,
+                  typename FUNC, std::size_t... IDXS, typename... ARGS,
+                  std::size_t... OUTIDXS, typename... OUTARGS>
+        SOA::Container<CONTAINER, SKIN, typename OUTARGS::field_type...>
+        __transform(std::index_sequence<IDXS...> seq,
+                    SOA::Typelist::typelist<ARGS...> tl,
+                    std::index_sequence<OUTIDXS...> outseq,
+                    SOA::Typelist::typelist<OUTARGS...> outtl,
+                    VIEW&& view, FUNC&& func)
+        {
+            using retval_type = SOA::Container<
+                    CONTAINER, SKIN, typename OUTARGS::field_type...>;
+            retval_type retVal;
+            _transform_into(seq, tl, outseq, outtl, retVal, view, func,
+                            all_fields_default_constructible<
+                                    typename retval_type::fields_typelist>());
             return retVal;
         }
 
@@ -387,6 +614,147 @@ namespace SOA {
         }
     }
 
+    namespace impl_algs {
+        /// column of VIEW that functor argument ARG refers to
+        template <typename VIEW, typename ARG>
+        using arg_column = find_idx<
+                typename std::remove_reference<VIEW>::type::fields_typelist,
+                typename std::remove_cv<
+                        typename std::remove_reference<ARG>::type>::type>;
+
+        /// is v different from all other arguments?
+        template <typename T>
+        constexpr bool none_equal(T /* unused */) noexcept { return true; }
+        template <typename T, typename HEAD, typename... TAIL>
+        constexpr bool none_equal(T v, HEAD head, TAIL... tail) noexcept
+        { return v != head && none_equal(v, tail...); }
+        /// are all arguments different from one another?
+        constexpr bool all_distinct() noexcept { return true; }
+        template <typename HEAD, typename... TAIL>
+        constexpr bool all_distinct(HEAD head, TAIL... tail) noexcept
+        { return none_equal(head, tail...) && all_distinct(tail...); }
+
+        /// iterator type of the column of VIEW for functor argument ARG
+        template <typename VIEW, typename ARG>
+        using arg_iterator = decltype(std::declval<VIEW&>().template begin<
+                                      arg_column<VIEW, ARG>::value>());
+
+        /// can for_each loop over raw pointers for these arguments?
+        template <typename VIEW, typename... ARGS>
+        struct raw_for_each_ok
+                : std::integral_constant<
+                          bool, SOA::Utils::ALL(
+                                        SOA::impl::is_contiguous_iterator<
+                                                arg_iterator<VIEW, ARGS> >::
+                                                value...) &&
+                                        // a column passed twice may alias
+                                        all_distinct(arg_column<VIEW, ARGS>::
+                                                             value...)> {};
+
+        /// alignment for which for_each generates a separate loop
+        constexpr std::size_t for_each_alignment = 64;
+
+        /// tell the compiler that p is suitably aligned (if ALIGNED)
+        template <bool ALIGNED, typename T>
+        T* assume_aligned(T* p) noexcept
+        {
+            return ALIGNED ? static_cast<T*>(SOA_ASSUME_ALIGNED(
+                                     p, for_each_alignment))
+                           : p;
+        }
+
+        /// loop for for_each over columns that do not alias
+        template <typename FUNC, typename... ARGS, typename... TS>
+        void _for_each_raw(std::size_t n, FUNC& func,
+                           SOA::Typelist::typelist<ARGS...> /* unused */,
+                           TS* SOA_RESTRICT... ptrs)
+        {
+            for (std::size_t i = 0; i < n; ++i) func(ARGS(ptrs[i])...);
+        }
+
+        /// can for_each loop over raw pointers, one run at a time?
+        template <typename VIEW, typename... ARGS>
+        struct segmented_for_each_ok
+                : std::integral_constant<
+                          bool, segmented_loop_ok<arg_iterator<
+                                        VIEW, ARGS>...>::value &&
+                                        // a column passed twice may alias
+                                        all_distinct(arg_column<VIEW, ARGS>::
+                                                             value...)> {};
+
+        /// helper for for_each: general iterators
+        template <typename VIEW, typename FUNC, std::size_t... IDXS,
+                  typename... ARGS>
+        void _for_each_segmented(std::index_sequence<IDXS...> seq,
+                                 SOA::Typelist::typelist<ARGS...> tl,
+                                 VIEW&& view, FUNC&& func,
+                                 std::false_type /* segmented */)
+        {
+            _for_each(seq, tl, std::forward<VIEW>(view),
+                      std::forward<FUNC>(func));
+        }
+
+        /// helper for for_each: columns made of contiguous runs (deque)
+        template <typename VIEW, typename FUNC, std::size_t... IDXS,
+                  typename... ARGS>
+        void _for_each_segmented(std::index_sequence<IDXS...> /* unused */,
+                                 SOA::Typelist::typelist<ARGS...> tl,
+                                 VIEW&& view, FUNC&& func,
+                                 std::true_type /* segmented */)
+        {
+            const std::size_t n = view.size();
+            auto its = std::make_tuple(
+                    view.template begin<
+                            arg_column<VIEW, ARGS>::value>()...);
+            for (std::size_t i = 0, len; i < n; i += len) {
+                len = common_run(n - i, std::get<IDXS>(its)...);
+                _for_each_raw(len, func, tl, &*std::get<IDXS>(its)...);
+                nop((std::get<IDXS>(its) += len, 0)...);
+            }
+        }
+
+        /// helper for for_each: not contiguous, but maybe segmented
+        template <typename VIEW, typename FUNC, std::size_t... IDXS,
+                  typename... ARGS>
+        void _for_each(std::index_sequence<IDXS...> seq,
+                       SOA::Typelist::typelist<ARGS...> tl, VIEW&& view,
+                       FUNC&& func, std::false_type /* contiguous */)
+        {
+            _for_each_segmented(
+                    seq, tl, std::forward<VIEW>(view),
+                    std::forward<FUNC>(func),
+                    segmented_for_each_ok<VIEW, ARGS...>());
+        }
+
+        /// helper for for_each: columns contiguous in memory
+        template <typename VIEW, typename FUNC, std::size_t... IDXS,
+                  typename... ARGS>
+        void _for_each(std::index_sequence<IDXS...> /* unused */,
+                       SOA::Typelist::typelist<ARGS...> tl, VIEW&& view,
+                       FUNC&& func, std::true_type /* contiguous */)
+        {
+            const std::size_t n = view.size();
+            if (!n) return;
+            // pointers to the start of the columns needed
+            const auto ptrs = std::make_tuple(
+                    &*view.template begin<
+                            arg_column<VIEW, ARGS>::value>()...);
+            if (SOA::Utils::ALL(0 == reinterpret_cast<std::uintptr_t>(
+                                             std::get<IDXS>(ptrs)) %
+                                             for_each_alignment...)) {
+                _for_each_raw(n, func, tl,
+                              assume_aligned<true>(std::get<IDXS>(ptrs))...);
+            } else {
+                _for_each_raw(n, func, tl, std::get<IDXS>(ptrs)...);
+            }
+        }
+
+        /// pick the right for_each implementation for VIEW and ARGS
+        template <typename VIEW, typename... ARGS>
+        raw_for_each_ok<VIEW, ARGS...>
+        for_each_dispatch(SOA::Typelist::typelist<ARGS...>) noexcept;
+    } // namespace impl_algs
+
     /** @brief apply a function to each element of a (SOA) View
      *
      * @param view          view to apply function to
@@ -414,6 +782,13 @@ namespace SOA {
      * are not sufficient to uniquely identify the fields of the view that are
      * required, a compiler error is produced (with a suitable diagnostic
      * message).
+     *
+     * If all columns the function needs are contiguous in memory (e.g.
+     * std::vector or SOA::SlabStorage), the loop runs over raw, non-aliasing
+     * pointers (with alignment hints if the columns are suitably aligned)
+     * so that simple functions vectorise like hand-written array loops.
+     * Columns stored in a std::deque are handled the same way, one
+     * stretch of elements contiguous in all columns at a time.
      */
     template <typename VIEW, typename FUNC>
     void for_each(VIEW&& view, FUNC&& func)
@@ -433,7 +808,1343 @@ namespace SOA {
         SOA::impl_algs::_for_each(
                 std::make_index_sequence<arg_typelist::size()>(),
                 arg_typelist(), std::forward<VIEW>(view),
-                std::forward<FUNC>(func));
+                std::forward<FUNC>(func),
+                decltype(SOA::impl_algs::for_each_dispatch<VIEW>(
+                        arg_typelist()))());
+    }
+
+    /** @brief add numbers, or std::tuples of numbers element by element
+     *
+     * Handy as reduction operation for SOA::transform_reduce when the
+     * functor returns several quantities at once.
+     */
+    struct elementwise_plus {
+        template <typename T>
+        T operator()(const T& a, const T& b) const
+        { return a + b; }
+        template <typename... TS>
+        std::tuple<TS...> operator()(const std::tuple<TS...>& a,
+                                     const std::tuple<TS...>& b) const
+        { return add(a, b, std::make_index_sequence<sizeof...(TS)>()); }
+
+    private:
+        template <typename TUP, std::size_t... IDXS>
+        static TUP add(const TUP& a, const TUP& b,
+                       std::index_sequence<IDXS...> /* unused */)
+        { return TUP((std::get<IDXS>(a) + std::get<IDXS>(b))...); }
+    };
+
+    namespace impl_algs {
+        /** @brief reduce func over rows [first, last) (last > first)
+         *
+         * Four independent accumulators, combined pairwise at the end, keep
+         * the dependency chain of the reduction from stalling the loop.
+         */
+        template <typename T, typename INS, typename RED, typename FUNC,
+                  std::size_t... IDXS, typename... ARGS>
+        T _transform_reduce(std::index_sequence<IDXS...> /* unused */,
+                            SOA::Typelist::typelist<ARGS...> /* unused */,
+                            const INS& ins, std::size_t first,
+                            std::size_t last, RED& reduce, FUNC& func)
+        {
+            if (last - first < 4) {
+                T acc(func(ARGS(std::get<IDXS>(ins)[first])...));
+                for (std::size_t i = first + 1; i < last; ++i)
+                    acc = reduce(acc,
+                                 T(func(ARGS(std::get<IDXS>(ins)[i])...)));
+                return acc;
+            }
+            T acc0(func(ARGS(std::get<IDXS>(ins)[first])...));
+            T acc1(func(ARGS(std::get<IDXS>(ins)[first + 1])...));
+            T acc2(func(ARGS(std::get<IDXS>(ins)[first + 2])...));
+            T acc3(func(ARGS(std::get<IDXS>(ins)[first + 3])...));
+            std::size_t i = first + 4;
+            for (; i + 4 <= last; i += 4) {
+                acc0 = reduce(acc0,
+                              T(func(ARGS(std::get<IDXS>(ins)[i])...)));
+                acc1 = reduce(acc1,
+                              T(func(ARGS(std::get<IDXS>(ins)[i + 1])...)));
+                acc2 = reduce(acc2,
+                              T(func(ARGS(std::get<IDXS>(ins)[i + 2])...)));
+                acc3 = reduce(acc3,
+                              T(func(ARGS(std::get<IDXS>(ins)[i + 3])...)));
+            }
+            for (; i < last; ++i) {
+                acc0 = reduce(acc0,
+                              T(func(ARGS(std::get<IDXS>(ins)[i])...)));
+            }
+            return reduce(reduce(acc0, acc1), reduce(acc2, acc3));
+        }
+
+        /// columns of view needed by the functor arguments ARGS
+        template <typename VIEW, typename... ARGS>
+        auto arg_columns(VIEW& view,
+                         SOA::Typelist::typelist<ARGS...> /* unused */)
+                -> decltype(std::make_tuple(column_start(
+                        view.template begin<
+                                arg_column<VIEW, ARGS>::value>())...))
+        {
+            return std::make_tuple(column_start(
+                    view.template begin<arg_column<VIEW, ARGS>::value>())...);
+        }
+    } // namespace impl_algs
+
+    /** @brief map each element of a (SOA) View, and reduce the results
+     *
+     * @param view          view to reduce
+     * @param init          initial value of the reduction
+     * @param reduce        binary reduction operation
+     * @param func          function/functor mapping an element to a value
+     *                      of (or convertible to) type T
+     *
+     * @returns reduce(init, reduce(func(row 0), reduce(func(row 1), ...)))
+     *          in unspecified order
+     *
+     * The arguments of func pick the fields of the view as for for_each.
+     * As for std::transform_reduce, reduce must be associative and
+     * commutative: rows are spread over several accumulators to let the
+     * loop run at full speed.
+     *
+     * Example:
+     * @code
+     * // total mass and centre of mass
+     * auto r = SOA::transform_reduce(view, std::make_tuple(0.f, 0.f),
+     *         SOA::elementwise_plus(),
+     *         [] (SOA::cref<f_m> m, SOA::cref<f_x> x) {
+     *             return std::make_tuple(float(m), m * x);
+     *         });
+     * float xcms = std::get<1>(r) / std::get<0>(r);
+     * @endcode
+     */
+    template <typename VIEW, typename T, typename RED, typename FUNC>
+    T transform_reduce(VIEW&& view, T init, RED reduce, FUNC&& func)
+    {
+        using arg_typelist =
+                typename SOA::impl_algs::callable_info<FUNC>::arg_typelist;
+        static_assert(
+                decltype(SOA::impl_algs::canFindArgs(
+                        std::declval<const VIEW&>(), arg_typelist()))::value,
+                "some function arguments not found in view");
+        static_assert(
+                decltype(SOA::impl_algs::uniqueArgs(
+                        std::declval<const VIEW&>(), arg_typelist()))::value,
+                "unable to uniquely match all arguments "
+                "- try using tagged types as argunents");
+        if (view.empty()) return init;
+        return reduce(init, SOA::impl_algs::_transform_reduce<T>(
+                                    std::make_index_sequence<
+                                            arg_typelist::size()>(),
+                                    arg_typelist(),
+                                    SOA::impl_algs::arg_columns(
+                                            view, arg_typelist()),
+                                    0, view.size(), reduce, func));
+    }
+
+    namespace impl_algs {
+        /// pair loops work on tiles of rows that fit into this many bytes
+        constexpr std::size_t pair_tile_bytes = 8192;
+
+        /// number of rows of VIEW per tile in pair loops
+        template <typename VIEW>
+        constexpr std::size_t pair_tile() noexcept
+        {
+            return (pair_tile_bytes / 16 <
+                    sizeof(typename std::remove_reference<
+                           VIEW>::type::value_type))
+                           ? 16
+                           : pair_tile_bytes /
+                                     sizeof(typename std::remove_reference<
+                                            VIEW>::type::value_type);
+        }
+
+        /// call func(a[i], b[j]) for all i in [ifirst, ilast), j in
+        /// [jfirst, jlast)
+        template <typename VA, typename VB, typename FUNC>
+        void pair_tile_full(VA& a, std::size_t ifirst, std::size_t ilast,
+                            VB& b, std::size_t jfirst, std::size_t jlast,
+                            FUNC& func)
+        {
+            for (std::size_t i = ifirst; i < ilast; ++i) {
+                auto&& ai = a[i];
+                for (std::size_t j = jfirst; j < jlast; ++j) func(ai, b[j]);
+            }
+        }
+
+        /// call func(v[i], v[j]) for first <= i < j < last
+        template <typename V, typename FUNC>
+        void pair_tile_triangle(V& v, std::size_t first, std::size_t last,
+                                FUNC& func)
+        {
+            for (std::size_t i = first; i < last; ++i) {
+                auto&& vi = v[i];
+                for (std::size_t j = i + 1; j < last; ++j) func(vi, v[j]);
+            }
+        }
+
+        /// pair loops over element proxies: func(a[i], b[j])
+        template <typename VA, typename VB, typename FUNC>
+        struct pair_proxy_kernel {
+            VA& a;
+            VB& b;
+            FUNC& func;
+            void full(std::size_t ifirst, std::size_t ilast,
+                      std::size_t jfirst, std::size_t jlast) const
+            { pair_tile_full(a, ifirst, ilast, b, jfirst, jlast, func); }
+            void triangle(std::size_t first, std::size_t last) const
+            { pair_tile_triangle(a, first, last, func); }
+        };
+
+        /// argument types of FUNC, if they can be inspected (else void)
+        template <typename FUNC, typename = void>
+        struct inspectable_args {
+            using type = void;
+        };
+        template <typename FUNC>
+        struct inspectable_args<FUNC, std::void_t<decltype(
+                &std::decay<FUNC>::type::operator())> > {
+            using type = typename callable_info<typename std::decay<
+                    FUNC>::type>::arg_typelist;
+        };
+
+        /// elements OFS, OFS + 1, ... of typelist TL
+        template <typename TL, std::size_t OFS, typename SEQ>
+        struct sub_typelist;
+        template <typename TL, std::size_t OFS, std::size_t... IDXS>
+        struct sub_typelist<TL, OFS, std::index_sequence<IDXS...> > {
+            using type = SOA::Typelist::typelist<
+                    typename TL::template at<OFS + IDXS>::type...>;
+        };
+        /// first half of typelist TL
+        template <typename TL>
+        using first_half = typename sub_typelist<
+                TL, 0,
+                decltype(std::make_index_sequence<TL::size() / 2>())>::type;
+        /// second half of typelist TL
+        template <typename TL>
+        using second_half = typename sub_typelist<
+                TL, TL::size() / 2,
+                decltype(std::make_index_sequence<TL::size() / 2>())>::type;
+
+        /// does TL pick fields, first half from VA, second half from VB?
+        template <typename VA, typename VB, typename TL>
+        struct pair_picks_fields : std::false_type {};
+        template <typename VA, typename VB, typename... ARGS>
+        struct pair_picks_fields<VA, VB, SOA::Typelist::typelist<ARGS...> >
+                : std::integral_constant<
+                          bool,
+                          sizeof...(ARGS) && !(sizeof...(ARGS) % 2) &&
+                                  decltype(uniqueArgs(
+                                          std::declval<const VA&>(),
+                                          first_half<SOA::Typelist::typelist<
+                                                  ARGS...> >()))::value &&
+                                  decltype(uniqueArgs(
+                                          std::declval<const VB&>(),
+                                          second_half<SOA::Typelist::typelist<
+                                                  ARGS...> >()))::value> {};
+
+        /// can a functor argument of type ARG modify the element?
+        template <typename ARG, typename = void>
+        struct writable_arg
+                : std::integral_constant<
+                          bool, std::is_lvalue_reference<ARG>::value &&
+                                        !std::is_const<typename std::
+                                                remove_reference<ARG>::
+                                                        type>::value> {};
+        template <typename ARG>
+        struct writable_arg<ARG, std::void_t<typename std::decay<
+                                         ARG>::type::tagged_reference_tag> >
+                : std::true_type {};
+        /// write back a row accumulator if func could have changed it
+        template <typename ARG, typename IT, typename T>
+        typename std::enable_if<writable_arg<ARG>::value>::type
+        store_acc_if_writable(IT it, std::size_t i, const T& val)
+        { it[i] = val; }
+        template <typename ARG, typename IT, typename T>
+        typename std::enable_if<!writable_arg<ARG>::value>::type
+        store_acc_if_writable(IT /* unused */, std::size_t /* unused */,
+                              const T& /* unused */) noexcept
+        {}
+
+        /// inner pair loop over j, b columns are iterators
+        template <typename FUNC, typename ACC, typename PB,
+                  std::size_t... IA, typename... ARGSA, std::size_t... IB,
+                  typename... ARGSB>
+        void _pair_row(std::index_sequence<IA...> /* unused */,
+                       SOA::Typelist::typelist<ARGSA...> /* unused */,
+                       std::index_sequence<IB...> /* unused */,
+                       SOA::Typelist::typelist<ARGSB...> /* unused */,
+                       FUNC& func, ACC& acc, const PB& pb,
+                       std::size_t jfirst, std::size_t jlast,
+                       std::false_type /* raw */)
+        {
+            for (std::size_t j = jfirst; j < jlast; ++j)
+                func(ARGSA(std::get<IA>(acc))...,
+                     ARGSB(std::get<IB>(pb)[j])...);
+        }
+        /// inner pair loop over j on raw pointers that do not alias
+        template <typename FUNC, typename ACC, std::size_t... IA,
+                  typename... ARGSA, typename... ARGSB, typename... TS>
+        void _pair_row_raw(std::index_sequence<IA...> /* unused */,
+                           SOA::Typelist::typelist<ARGSA...> /* unused */,
+                           SOA::Typelist::typelist<ARGSB...> /* unused */,
+                           FUNC& func, ACC& acc, std::size_t jfirst,
+                           std::size_t jlast, TS* SOA_RESTRICT... pb)
+        {
+            for (std::size_t j = jfirst; j < jlast; ++j)
+                func(ARGSA(std::get<IA>(acc))..., ARGSB(pb[j])...);
+        }
+        template <typename FUNC, typename ACC, typename PB,
+                  typename SEQA, typename TLA, std::size_t... IB,
+                  typename TLB>
+        void _pair_row(SEQA seqa, TLA tla,
+                       std::index_sequence<IB...> /* unused */, TLB tlb,
+                       FUNC& func, ACC& acc, const PB& pb,
+                       std::size_t jfirst, std::size_t jlast,
+                       std::true_type /* raw */)
+        {
+            _pair_row_raw(seqa, tla, tlb, func, acc, jfirst, jlast,
+                          std::get<IB>(pb)...);
+        }
+
+        /// tuple of the values in a row of columns PA
+        template <typename PA, typename SEQ>
+        struct row_values;
+        template <typename PA, std::size_t... IA>
+        struct row_values<PA, std::index_sequence<IA...> > {
+            using type = std::tuple<typename std::decay<decltype(
+                    std::get<IA>(std::declval<PA&>())[0])>::type...>;
+        };
+
+        /** @brief pair loops picking fields: func(a fields..., b fields...)
+         *
+         * The fields of row i of a are copied into local accumulators
+         * which stay in registers while func runs over a stretch of rows
+         * of b, and are then written back. The inner loop thus only
+         * streams through the b columns, and vectorises like a plain
+         * array loop.
+         */
+        template <typename FUNC, typename PA, typename PB, typename TLA,
+                  typename TLB, typename RAW>
+        struct pair_field_kernel;
+        template <typename FUNC, typename PA, typename PB,
+                  typename... ARGSA, typename... ARGSB, typename RAW>
+        struct pair_field_kernel<FUNC, PA, PB,
+                                 SOA::Typelist::typelist<ARGSA...>,
+                                 SOA::Typelist::typelist<ARGSB...>, RAW> {
+            using seqa =
+                    decltype(std::make_index_sequence<sizeof...(ARGSA)>());
+            using seqb =
+                    decltype(std::make_index_sequence<sizeof...(ARGSB)>());
+            using tla = SOA::Typelist::typelist<ARGSA...>;
+            using tlb = SOA::Typelist::typelist<ARGSB...>;
+            /// accumulators for the fields of a row of a
+            using acc_type = typename row_values<PA, seqa>::type;
+
+            FUNC& func;
+            PA pa;
+            PB pb;
+
+            template <std::size_t... IA>
+            acc_type load(std::size_t i,
+                          std::index_sequence<IA...> /* unused */) const
+            { return acc_type(std::get<IA>(pa)[i]...); }
+            template <std::size_t... IA>
+            void store(std::size_t i, const acc_type& acc,
+                       std::index_sequence<IA...> /* unused */) const
+            {
+                nop((store_acc_if_writable<ARGSA>(std::get<IA>(pa), i,
+                                                  std::get<IA>(acc)),
+                     0)...);
+            }
+            void row(std::size_t i, std::size_t jfirst,
+                     std::size_t jlast) const
+            {
+                acc_type acc(load(i, seqa()));
+                _pair_row(seqa(), tla(), seqb(), tlb(), func, acc, pb,
+                          jfirst, jlast, RAW());
+                store(i, acc, seqa());
+            }
+            void full(std::size_t ifirst, std::size_t ilast,
+                      std::size_t jfirst, std::size_t jlast) const
+            {
+                for (std::size_t i = ifirst; i < ilast; ++i)
+                    row(i, jfirst, jlast);
+            }
+            void triangle(std::size_t first, std::size_t last) const
+            {
+                for (std::size_t i = first; i + 1 < last; ++i)
+                    row(i, i + 1, last);
+            }
+        };
+
+        /// raw_for_each_ok for a typelist of arguments
+        template <typename VIEW, typename TL>
+        struct raw_args_ok;
+        template <typename VIEW, typename... ARGS>
+        struct raw_args_ok<VIEW, SOA::Typelist::typelist<ARGS...> >
+                : raw_for_each_ok<VIEW, ARGS...> {};
+
+        /// pick the pair loop kernel: functors taking element proxies
+        template <typename VA, typename VB, typename FUNC,
+                  bool = pair_picks_fields<
+                          VA, VB,
+                          typename inspectable_args<FUNC>::type>::value>
+        struct pair_kernel_for {
+            using type = pair_proxy_kernel<VA, VB, FUNC>;
+            static type make(VA& a, VB& b, FUNC& func)
+            { return {a, b, func}; }
+        };
+        /// pick the pair loop kernel: functors picking fields
+        template <typename VA, typename VB, typename FUNC>
+        struct pair_kernel_for<VA, VB, FUNC, true> {
+            using args = typename inspectable_args<FUNC>::type;
+            using args_a = first_half<args>;
+            using args_b = second_half<args>;
+            using type = pair_field_kernel<
+                    FUNC,
+                    decltype(arg_columns(std::declval<VA&>(), args_a())),
+                    decltype(arg_columns(std::declval<VB&>(), args_b())),
+                    args_a, args_b,
+                    std::integral_constant<
+                            bool, raw_args_ok<VB, args_b>::value> >;
+            static type make(VA& a, VB& b, FUNC& func)
+            { return {func, arg_columns(a, args_a()),
+                      arg_columns(b, args_b())}; }
+        };
+        /// kernel for pair loops over a and b with func
+        template <typename VA, typename VB, typename FUNC>
+        typename pair_kernel_for<VA, VB, FUNC>::type
+        make_pair_kernel(VA& a, VB& b, FUNC& func)
+        { return pair_kernel_for<VA, VB, FUNC>::make(a, b, func); }
+    } // namespace impl_algs
+
+    /** @brief call a function for all pairs of elements of two views
+     *
+     * @param a             first view
+     * @param b             second view
+     * @param func          function/functor to call as func(a[i], b[j])
+     *
+     * Calls func(a[i], b[j]) for all i < a.size() and j < b.size(). To
+     * make good use of the cache, b is processed in tiles that fit into
+     * the L1 cache, and each tile is paired with all elements of a before
+     * moving on to the next one; for a given tile of b, elements of a are
+     * visited in order.
+     *
+     * Instead of element proxies, func may pick fields like for_each
+     * does: the first half of its arguments picks fields of a[i], the
+     * second half fields of b[j]. In that case, the fields of a[i] are
+     * held in local accumulators (written back if func takes them by
+     * non-const reference or SOA::ref) while func runs over the tile of
+     * b, so the inner loop over j runs over the raw columns of b and
+     * vectorises. a and b must then not share rows that func writes to.
+     *
+     * Example:
+     * @code
+     * // count track pairs that are compatible with a common vertex
+     * std::size_t npairs = 0;
+     * SOA::for_each_pair(tracks, vertices,
+     *         [&npairs] (Tracks::const_reference t,
+     *                    Vertices::const_reference v)
+     *         { npairs += compatible(t, v); });
+     * // field-picking form: potential of charges in a at points in b
+     * SOA::for_each_pair(charges, points,
+     *         [] (SOA::cref<f_x> xa, SOA::cref<f_q> q,
+     *             SOA::cref<f_x> xb, SOA::ref<f_phi> phi)
+     *         { phi += q / std::abs(xb - xa); });
+     * @endcode
+     */
+    template <typename VA, typename VB, typename FUNC>
+    void for_each_pair(VA&& a, VB&& b, FUNC&& func)
+    {
+        const std::size_t na = a.size(), nb = b.size();
+        const std::size_t tile = SOA::impl_algs::pair_tile<VB>();
+        const auto kernel = SOA::impl_algs::make_pair_kernel(a, b, func);
+        for (std::size_t j = 0; j < nb; j += tile)
+            kernel.full(0, na, j, std::min(nb, j + tile));
+    }
+
+    /** @brief call a function once for each unordered pair of elements
+     *
+     * @param view          view
+     * @param func          function/functor to call as func(v[i], v[j])
+     *
+     * Calls func(view[i], view[j]) for all i < j < view.size(), i.e. once
+     * for each pair of distinct elements. This is what is needed for
+     * symmetric interactions: func can update both elements (e.g. apply a
+     * force to one, and the opposite force to the other), which halves the
+     * work compared to for_each_pair(view, view, func). The pairs are
+     * visited in tiles that fit into the L1 cache, so that both elements
+     * of a pair are usually found in the cache.
+     *
+     * As for for_each_pair, func may pick fields instead: the first half
+     * of its arguments picks fields of view[i], the second half those of
+     * view[j], and the inner loop over j vectorises.
+     *
+     * Example:
+     * @code
+     * SOA::for_each_unique_pair(particles,
+     *         [dt] (Particles::reference a, Particles::reference b) {
+     *             const float dx = b.x() - a.x();
+     *             const float f = dt * force(dx);
+     *             a.px() += f * dx, b.px() -= f * dx;
+     *         });
+     * // the same, picking fields
+     * SOA::for_each_unique_pair(particles,
+     *         [dt] (SOA::cref<f_x> xa, SOA::ref<f_px> pxa,
+     *               SOA::cref<f_x> xb, SOA::ref<f_px> pxb) {
+     *             const float dx = xb - xa, f = dt * force(dx);
+     *             pxa += f * dx, pxb -= f * dx;
+     *         });
+     * @endcode
+     */
+    template <typename VIEW, typename FUNC>
+    void for_each_unique_pair(VIEW&& view, FUNC&& func)
+    {
+        const std::size_t n = view.size();
+        const std::size_t tile = SOA::impl_algs::pair_tile<VIEW>();
+        const auto kernel =
+                SOA::impl_algs::make_pair_kernel(view, view, func);
+        for (std::size_t j = 0; j < n; j += tile) {
+            const std::size_t jend = std::min(n, j + tile);
+            if (j) kernel.full(0, j, j, jend);
+            kernel.triangle(j, jend);
+        }
+    }
+
+    namespace impl_algs {
+        /// type of the sort key in field FIELD of VIEW
+        template <typename FIELD, typename VIEW>
+        struct sort_key {
+            using type = typename std::decay<decltype(
+                    *std::declval<typename std::remove_reference<
+                            VIEW>::type&>()
+                             .template begin<FIELD>())>::type;
+        };
+        /// sort with std::sort
+        struct unstable_sorter {
+            template <typename IT, typename COMP>
+            void operator()(IT first, IT last, COMP comp) const
+            { std::sort(first, last, comp); }
+        };
+        /// sort with std::stable_sort
+        struct stable_sorter {
+            template <typename IT, typename COMP>
+            void operator()(IT first, IT last, COMP comp) const
+            { std::stable_sort(first, last, comp); }
+        };
+        /// compare (key, index) pairs by key only
+        template <typename ENTRY, typename COMP>
+        struct key_compare {
+            COMP comp;
+            bool operator()(const ENTRY& a, const ENTRY& b)
+            { return comp(a.first, b.first); }
+        };
+        /// rearrange column starting at first such that new[i] = old[perm[i]]
+        template <typename IT, typename SZ>
+        void permute_column(IT first, const std::vector<SZ>& perm)
+        {
+            using value_type = typename std::iterator_traits<IT>::value_type;
+            std::vector<value_type> tmp;
+            tmp.reserve(perm.size());
+            for (SZ idx : perm) tmp.emplace_back(std::move(first[idx]));
+            std::move(tmp.begin(), tmp.end(), first);
+        }
+        /// apply permutation perm to all columns of view
+        template <typename VIEW, typename SZ, std::size_t... IDXS>
+        void permute_columns(VIEW& view, const std::vector<SZ>& perm,
+                             std::index_sequence<IDXS...> /* unused */)
+        {
+            nop((permute_column(view.template begin<IDXS>(), perm), 0)...);
+        }
+        /// new[i] = old[perm[i]] in place by following the cycles of perm
+        template <typename IT, typename SZ>
+        void permute_column_in_place(IT first, const std::vector<SZ>& perm,
+                                     std::vector<bool>& visited)
+        {
+            using value_type = typename std::iterator_traits<IT>::value_type;
+            visited.assign(perm.size(), false);
+            for (std::size_t s = 0; s < perm.size(); ++s) {
+                if (visited[s]) continue;
+                visited[s] = true;
+                if (std::size_t(perm[s]) == s) continue;
+                value_type tmp(std::move(first[s]));
+                std::size_t j = s;
+                for (std::size_t k; (k = perm[j]) != s; j = k) {
+                    first[j] = std::move(first[k]);
+                    visited[k] = true;
+                }
+                first[j] = std::move(tmp);
+            }
+        }
+        /// apply permutation perm to all columns of view in place
+        template <typename VIEW, typename SZ, std::size_t... IDXS>
+        void permute_columns_in_place(
+                VIEW& view, const std::vector<SZ>& perm,
+                std::index_sequence<IDXS...> /* unused */)
+        {
+            std::vector<bool> visited;
+            nop((permute_column_in_place(view.template begin<IDXS>(), perm,
+                                         visited),
+                 0)...);
+        }
+        /// helper for sort_by and stable_sort_by
+        template <typename FIELD, typename VIEW, typename COMP,
+                  typename SORTER>
+        void _sort_by(VIEW& view, COMP comp, SORTER sorter)
+        {
+            using size_type = typename VIEW::size_type;
+            using entry = std::pair<typename sort_key<FIELD, VIEW>::type,
+                                    size_type>;
+            // sort (key, index) pairs - only the keys get moved around
+            std::vector<entry> keys;
+            keys.reserve(view.size());
+            size_type i = 0;
+            for (auto it = view.template begin<FIELD>(),
+                      end = view.template end<FIELD>();
+                 end != it; ++it, ++i)
+                keys.emplace_back(*it, i);
+            sorter(keys.begin(), keys.end(),
+                   key_compare<entry, COMP>{comp});
+            std::vector<size_type> perm;
+            perm.reserve(keys.size());
+            for (const entry& e : keys) perm.push_back(e.second);
+            std::vector<entry>().swap(keys);
+            // then move each column into place in one pass
+            permute_columns(view, perm,
+                            std::make_index_sequence<
+                                    VIEW::fields_typelist::size()>());
+        }
+    } // namespace impl_algs
+
+    /** @brief rearrange the rows of a (SOA) View: new[i] = old[perm[i]]
+     *
+     * @param view          view (or container) to rearrange
+     * @param perm          permutation of 0, ..., view.size() - 1
+     *
+     * Rows are not moved as a whole; instead, the columns are rearranged
+     * one after the other, each in a single streaming pass through a
+     * temporary buffer for that column. The memory needed on top of the
+     * view is thus that of one column, not that of a copy of the view.
+     * See apply_permutation_in_place if even that is too much.
+     */
+    template <typename VIEW, typename SZ>
+    void apply_permutation(VIEW&& view, const std::vector<SZ>& perm)
+    {
+        using view_type = typename std::remove_reference<VIEW>::type;
+        assert(perm.size() == view.size());
+        SOA::impl_algs::permute_columns(
+                view, perm,
+                std::make_index_sequence<
+                        view_type::fields_typelist::size()>());
+    }
+
+    /** @brief rearrange the rows of a (SOA) View in place
+     *
+     * @param view          view (or container) to rearrange
+     * @param perm          permutation of 0, ..., view.size() - 1
+     *
+     * Like apply_permutation, but each column is rearranged in place by
+     * following the cycles of perm, keeping track of the rows already
+     * visited in a bit mask. Beyond that bit mask, only a single element
+     * is needed as temporary storage. The access pattern is random,
+     * though, so this is slower than apply_permutation unless memory is
+     * tight.
+     */
+    template <typename VIEW, typename SZ>
+    void apply_permutation_in_place(VIEW&& view, const std::vector<SZ>& perm)
+    {
+        using view_type = typename std::remove_reference<VIEW>::type;
+        assert(perm.size() == view.size());
+        SOA::impl_algs::permute_columns_in_place(
+                view, perm,
+                std::make_index_sequence<
+                        view_type::fields_typelist::size()>());
+    }
+
+    /** @brief sort a (SOA) View by the given field
+     *
+     * @tparam FIELD        field to sort by
+     * @param view          view (or container) to sort in place
+     * @param comp          comparison function for values of FIELD
+     *                      (default: std::less)
+     *
+     * Sorting with std::sort and a comparison on the element proxies swaps
+     * whole elements, touching every column for every swap. Instead, this
+     * sorts (key, index) pairs, and then moves each column into place in a
+     * single streaming pass.
+     *
+     * Example:
+     * @code
+     * SOA::Container<std::vector, SOAPoint> c = get_from_elsewhere();
+     * SOA::sort_by<f_x>(c); // ascending in x
+     * SOA::sort_by<f_y>(c, std::greater<float>()); // descending in y
+     * @endcode
+     */
+    template <typename FIELD, typename VIEW,
+              typename COMP = std::less<typename SOA::impl_algs::sort_key<
+                      FIELD, VIEW>::type> >
+    void sort_by(VIEW&& view, COMP comp = COMP())
+    {
+        SOA::impl_algs::_sort_by<FIELD>(view, comp,
+                                        SOA::impl_algs::unstable_sorter());
+    }
+
+    /** @brief stable sort a (SOA) View by the given field
+     *
+     * @tparam FIELD        field to sort by
+     * @param view          view (or container) to sort in place
+     * @param comp          comparison function for values of FIELD
+     *                      (default: std::less)
+     *
+     * Like sort_by, but elements with equivalent keys keep their order.
+     */
+    template <typename FIELD, typename VIEW,
+              typename COMP = std::less<typename SOA::impl_algs::sort_key<
+                      FIELD, VIEW>::type> >
+    void stable_sort_by(VIEW&& view, COMP comp = COMP())
+    {
+        SOA::impl_algs::_sort_by<FIELD>(view, comp,
+                                        SOA::impl_algs::stable_sorter());
+    }
+
+    namespace impl_algs {
+        /// map keys to unsigned integers with the same ordering (if possible)
+        template <typename T, typename = void>
+        struct radix_key {
+            static constexpr bool supported = false;
+        };
+        /// unsigned integers: nothing to do
+        template <typename T>
+        struct radix_key<T, typename std::enable_if<
+                                    std::is_integral<T>::value &&
+                                    std::is_unsigned<T>::value>::type> {
+            static constexpr bool supported = true;
+            using type = T;
+            static type get(T v) noexcept { return v; }
+        };
+        /// signed integers: flip the sign bit
+        template <typename T>
+        struct radix_key<T, typename std::enable_if<
+                                    std::is_integral<T>::value &&
+                                    std::is_signed<T>::value>::type> {
+            static constexpr bool supported = true;
+            using type = typename std::make_unsigned<T>::type;
+            static type get(T v) noexcept
+            {
+                return type(v) ^ (type(1) << (8 * sizeof(type) - 1));
+            }
+        };
+        /// IEEE floats: flip the sign bit of positive, all bits of negative
+        template <typename T>
+        struct radix_key<T, typename std::enable_if<
+                                    std::is_floating_point<T>::value &&
+                                    std::numeric_limits<T>::is_iec559 &&
+                                    (sizeof(T) == sizeof(std::uint32_t) ||
+                                     sizeof(T) == sizeof(std::uint64_t))>::
+                                    type> {
+            static constexpr bool supported = true;
+            using type = typename std::conditional<
+                    sizeof(T) == sizeof(std::uint32_t), std::uint32_t,
+                    std::uint64_t>::type;
+            static type get(T v) noexcept
+            {
+                type u;
+                std::memcpy(&u, &v, sizeof(u));
+                constexpr type sign = type(1) << (8 * sizeof(type) - 1);
+                return (u & sign) ? ~u : (u | sign);
+            }
+        };
+        /// radix sort: size of a digit
+        constexpr std::size_t radix = 256;
+        /// radix sort: histogram all digits of key k
+        template <typename UKEY>
+        void radix_histogram(std::vector<std::size_t>& hist, UKEY k)
+        {
+            for (std::size_t p = 0; p < sizeof(UKEY); ++p)
+                ++hist[p * radix + ((k >> (8 * p)) & 0xff)];
+        }
+        /** @brief sort unsigned keys, permuting perm along with them
+         *
+         * hist must hold the histograms of all digits of the keys (see
+         * radix_histogram).
+         */
+        template <typename UKEY, typename IDX>
+        void _radix_sort_keys(std::vector<UKEY>& keys, std::vector<IDX>& perm,
+                              std::vector<std::size_t>& hist)
+        {
+            constexpr std::size_t passes = sizeof(UKEY);
+            const std::size_t n = keys.size();
+            std::vector<UKEY> keys2(n);
+            std::vector<IDX> perm2(n);
+            // one stable counting sort pass per byte, least significant
+            // first; bytes which are the same in all keys are skipped
+            for (std::size_t p = 0; p < passes && n; ++p) {
+                std::size_t* h = &hist[p * radix];
+                if (n == h[(keys[0] >> (8 * p)) & 0xff]) continue;
+                std::size_t sum = 0;
+                for (std::size_t d = 0; d < radix; ++d) {
+                    const std::size_t cnt = h[d];
+                    h[d] = sum;
+                    sum += cnt;
+                }
+                for (std::size_t i = 0; i < n; ++i) {
+                    const std::size_t pos = h[(keys[i] >> (8 * p)) & 0xff]++;
+                    keys2[pos] = keys[i];
+                    perm2[pos] = perm[i];
+                }
+                keys.swap(keys2);
+                perm.swap(perm2);
+            }
+        }
+        /// helper for radix_sort_by (IDX is the type used for indices)
+        template <typename FIELD, typename IDX, typename VIEW>
+        void _radix_sort_by(VIEW& view)
+        {
+            using traits =
+                    radix_key<typename sort_key<FIELD, VIEW>::type>;
+            using ukey = typename traits::type;
+            const std::size_t n = view.size();
+            // scatter keys, and histogram all digits in a single pass
+            std::vector<ukey> keys(n);
+            std::vector<IDX> perm(n);
+            std::vector<std::size_t> hist(sizeof(ukey) * radix, 0);
+            {
+                std::size_t i = 0;
+                for (auto it = view.template begin<FIELD>(),
+                          end = view.template end<FIELD>();
+                     end != it; ++it, ++i) {
+                    const ukey k = traits::get(*it);
+                    keys[i] = k;
+                    perm[i] = IDX(i);
+                    radix_histogram(hist, k);
+                }
+            }
+            _radix_sort_keys(keys, perm, hist);
+            std::vector<ukey>().swap(keys);
+            // then move each column into place in one pass
+            permute_columns(view, perm,
+                            std::make_index_sequence<
+                                    VIEW::fields_typelist::size()>());
+        }
+    } // namespace impl_algs
+
+    /** @brief sort a (SOA) View by the given field using a radix sort
+     *
+     * @tparam FIELD        field to sort by (integral or IEEE float)
+     * @param view          view (or container) to sort in place
+     *
+     * This is a stable least significant digit radix sort on the bytes of
+     * the key, i.e. it runs in linear time. Keys are sorted in ascending
+     * order; for floating point keys, -0 sorts before +0, and NaNs with
+     * the sign bit set/cleared go to the front/back. Like sort_by, the
+     * other columns are moved into place in one pass each at the end.
+     */
+    template <typename FIELD, typename VIEW>
+    void radix_sort_by(VIEW&& view)
+    {
+        using view_type = typename std::remove_reference<VIEW>::type;
+        static_assert(SOA::impl_algs::radix_key<typename SOA::impl_algs::
+                                                        sort_key<FIELD,
+                                                                 VIEW>::
+                                                                type>::
+                              supported,
+                      "radix_sort_by needs an integral or IEEE float key");
+        // 32 bit indices are enough most of the time, and save bandwidth
+        if (view.size() <= std::numeric_limits<std::uint32_t>::max())
+            SOA::impl_algs::_radix_sort_by<FIELD, std::uint32_t>(view);
+        else
+            SOA::impl_algs::_radix_sort_by<
+                    FIELD, typename view_type::size_type>(view);
+    }
+
+    /// space filling curves for reorder_by_space_filling_curve
+    enum class space_filling_curve {
+        morton, ///< Z-order: interleave the bits of the coordinates
+        hilbert ///< Hilbert curve: neighbours on curve are neighbours
+    };
+
+    namespace impl_algs {
+        /** @brief turn coordinates into "transposed" Hilbert index
+         *
+         * x holds D coordinates of BITS bits each; afterwards, interleaving
+         * their bits gives the position along the Hilbert curve (J. Skilling,
+         * "Programming the Hilbert curve", AIP Conf. Proc. 707, 381 (2004)).
+         */
+        template <std::size_t D>
+        void hilbert_transpose(std::array<std::uint64_t, D>& x,
+                               unsigned bits) noexcept
+        {
+            const std::uint64_t m = std::uint64_t(1) << (bits - 1);
+            // inverse undo
+            for (std::uint64_t q = m; q > 1; q >>= 1) {
+                const std::uint64_t p = q - 1;
+                for (std::size_t i = 0; i < D; ++i) {
+                    if (x[i] & q) {
+                        x[0] ^= p;
+                    } else {
+                        const std::uint64_t t = (x[0] ^ x[i]) & p;
+                        x[0] ^= t, x[i] ^= t;
+                    }
+                }
+            }
+            // Gray encode
+            for (std::size_t i = 1; i < D; ++i) x[i] ^= x[i - 1];
+            std::uint64_t t = 0;
+            for (std::uint64_t q = m; q > 1; q >>= 1)
+                if (x[D - 1] & q) t ^= q - 1;
+            for (std::size_t i = 0; i < D; ++i) x[i] ^= t;
+        }
+
+        /// interleave the low bits of D coordinates (x[0] most significant)
+        template <std::size_t D>
+        std::uint64_t interleave_bits(const std::array<std::uint64_t, D>& x,
+                                      unsigned bits) noexcept
+        {
+            std::uint64_t key = 0;
+            for (unsigned b = bits; b--;)
+                for (std::size_t i = 0; i < D; ++i)
+                    key = (key << 1) | ((x[i] >> b) & 1);
+            return key;
+        }
+
+        /// helper for reorder_by_space_filling_curve
+        template <typename IDX, typename VIEW, typename... FIELDS>
+        void _reorder_by_sfc(VIEW& view, space_filling_curve curve,
+                             SOA::Typelist::typelist<FIELDS...>
+                             /* unused */)
+        {
+            constexpr std::size_t dim = sizeof...(FIELDS);
+            // as many bits per coordinate as fit into a 64 bit key
+            constexpr unsigned bits = (64 / dim < 32) ? 64 / dim : 32;
+            const std::size_t n = view.size();
+            if (n < 2) return;
+            // bounding box
+            std::array<double, dim> lo, hi, scale;
+            lo = hi = std::array<double, dim>{{
+                    double(*view.template begin<FIELDS>())...}};
+            for (std::size_t i = 1; i < n; ++i) {
+                const std::array<double, dim> x{{
+                        double(view.template begin<FIELDS>()[i])...}};
+                for (std::size_t d = 0; d < dim; ++d) {
+                    lo[d] = std::min(lo[d], x[d]);
+                    hi[d] = std::max(hi[d], x[d]);
+                }
+            }
+            const double maxq = double((std::uint64_t(1) << bits) - 1);
+            for (std::size_t d = 0; d < dim; ++d)
+                scale[d] = (hi[d] > lo[d]) ? maxq / (hi[d] - lo[d]) : 0.;
+            // keys along the curve, and histograms for the radix sort
+            std::vector<std::uint64_t> keys(n);
+            std::vector<IDX> perm(n);
+            std::vector<std::size_t> hist(sizeof(std::uint64_t) * radix, 0);
+            for (std::size_t i = 0; i < n; ++i) {
+                const std::array<double, dim> x{{
+                        double(view.template begin<FIELDS>()[i])...}};
+                std::array<std::uint64_t, dim> q;
+                for (std::size_t d = 0; d < dim; ++d) {
+                    const double v = (x[d] - lo[d]) * scale[d];
+                    q[d] = (v > 0.) ? std::uint64_t(std::min(v, maxq)) : 0;
+                }
+                if (space_filling_curve::hilbert == curve)
+                    hilbert_transpose(q, bits);
+                keys[i] = interleave_bits(q, bits);
+                perm[i] = IDX(i);
+                radix_histogram(hist, keys[i]);
+            }
+            _radix_sort_keys(keys, perm, hist);
+            std::vector<std::uint64_t>().swap(keys);
+            // then move each column into place in one pass
+            permute_columns(view, perm,
+                            std::make_index_sequence<
+                                    VIEW::fields_typelist::size()>());
+        }
+    } // namespace impl_algs
+
+    /** @brief reorder a (SOA) View along a space filling curve
+     *
+     * @tparam FIELDS       coordinate fields (one to three, or more)
+     * @param view          view (or container) to reorder in place
+     * @param curve         space filling curve to use (Morton or Hilbert)
+     *
+     * The coordinates are scaled to the bounding box of the view, and
+     * quantised to as many bits as fit into a 64 bit key along the curve
+     * (32 bits for one or two coordinates, 21 bits for three). The view is
+     * then radix sorted by that key, and each column is moved into place in
+     * one pass at the end. Afterwards, elements close to each other in
+     * space tend to be close to each other in memory, which helps the cache
+     * in neighbour searches and tree walks. The Hilbert curve preserves
+     * locality better than the Morton (Z-order) curve, at the price of a
+     * more expensive key calculation.
+     *
+     * Example:
+     * @code
+     * SOA::reorder_by_space_filling_curve<f_x, f_y, f_z>(
+     *         particles, SOA::space_filling_curve::hilbert);
+     * @endcode
+     */
+    template <typename... FIELDS, typename VIEW>
+    void reorder_by_space_filling_curve(
+            VIEW&& view,
+            space_filling_curve curve = space_filling_curve::morton)
+    {
+        using view_type = typename std::remove_reference<VIEW>::type;
+        static_assert(sizeof...(FIELDS) > 0, "need coordinate fields");
+        static_assert(sizeof...(FIELDS) <= 64, "too many coordinate fields");
+        if (view.size() <= std::numeric_limits<std::uint32_t>::max()) {
+            SOA::impl_algs::_reorder_by_sfc<std::uint32_t>(
+                    view, curve, SOA::Typelist::typelist<FIELDS...>());
+        } else {
+            SOA::impl_algs::_reorder_by_sfc<typename view_type::size_type>(
+                    view, curve, SOA::Typelist::typelist<FIELDS...>());
+        }
+    }
+
+    namespace impl_algs {
+        /// helper for bucket_by (IDX is the type used for indices)
+        template <typename FIELD, typename IDX, typename VIEW,
+                  typename KEYFUNC>
+        std::vector<std::size_t> _bucket_by(VIEW& view,
+                                            std::size_t nbuckets,
+                                            KEYFUNC& keyfunc)
+        {
+            const std::size_t n = view.size();
+            std::vector<std::size_t> offsets(nbuckets + 1, 0);
+            // histogram the bucket numbers, remembering them for later
+            std::vector<IDX> perm(n);
+            {
+                std::size_t i = 0;
+                for (auto it = view.template begin<FIELD>(),
+                          end = view.template end<FIELD>();
+                     end != it; ++it, ++i) {
+                    const std::size_t b = keyfunc(*it);
+                    if (b >= nbuckets)
+                        throw std::out_of_range(
+                                "bucket_by: bucket number out of range");
+                    perm[i] = IDX(b);
+                    ++offsets[b + 1];
+                }
+            }
+            for (std::size_t b = 1; b <= nbuckets; ++b)
+                offsets[b] += offsets[b - 1];
+            // turn bucket numbers into the (stable) permutation
+            {
+                std::vector<IDX> buckets(n);
+                buckets.swap(perm);
+                std::vector<std::size_t> next(offsets.begin(),
+                                              offsets.end() - 1);
+                for (std::size_t i = 0; i < n; ++i)
+                    perm[next[buckets[i]]++] = IDX(i);
+            }
+            // then move each column into place in one pass
+            permute_columns(view, perm,
+                            std::make_index_sequence<
+                                    VIEW::fields_typelist::size()>());
+            return offsets;
+        }
+    } // namespace impl_algs
+
+    /** @brief split a (SOA) View into buckets by the value of a field
+     *
+     * @tparam FIELD        field to compute the bucket number from
+     * @param view          view (or container) to reorder in place
+     * @param nbuckets      number of buckets
+     * @param keyfunc       maps a value of FIELD to its bucket number
+     *                      (must be less than nbuckets)
+     *
+     * @returns offsets of the buckets (nbuckets + 1 of them): bucket b
+     *          ends up in rows [offsets[b], offsets[b + 1])
+     *
+     * @throws std::out_of_range if keyfunc returns a bucket number of
+     *         nbuckets or more (view is left unchanged in that case)
+     *
+     * This is a multi-way stable_partition in linear time: a pass over
+     * FIELD to histogram the bucket numbers, a prefix sum over the
+     * histogram, and a single streaming pass to move each column into
+     * place. Elements within the same bucket keep their relative order.
+     *
+     * Example:
+     * @code
+     * // hits has a field f_layer holding the detector layer (0 to 11)
+     * const auto offsets = SOA::bucket_by<f_layer>(hits, 12,
+     *         [] (int layer) { return std::size_t(layer); });
+     * for (std::size_t l = 0; l < 12; ++l) {
+     *     for (auto i = offsets[l]; i != offsets[l + 1]; ++i)
+     *         process(l, hits[i]);
+     * }
+     * @endcode
+     */
+    template <typename FIELD, typename VIEW, typename KEYFUNC>
+    std::vector<std::size_t> bucket_by(VIEW&& view, std::size_t nbuckets,
+                                       KEYFUNC&& keyfunc)
+    {
+        using view_type = typename std::remove_reference<VIEW>::type;
+        // 32 bit indices are enough most of the time, and save bandwidth
+        if (view.size() <= std::numeric_limits<std::uint32_t>::max() &&
+            nbuckets <= std::numeric_limits<std::uint32_t>::max()) {
+            return SOA::impl_algs::_bucket_by<FIELD, std::uint32_t>(
+                    view, nbuckets, keyfunc);
+        } else {
+            return SOA::impl_algs::_bucket_by<
+                    FIELD, typename view_type::size_type>(view, nbuckets,
+                                                          keyfunc);
+        }
+    }
+
+    namespace impl_algs {
+        /// evaluate predicate, mask[i] = (pred(element i) == MATCH)
+        template <bool MATCH, typename VIEW, typename PRED,
+                  std::size_t... IDXS, typename... ARGS>
+        void _predicate_mask(std::index_sequence<IDXS...> /* unused */,
+                             SOA::Typelist::typelist<ARGS...> /* unused */,
+                             VIEW& view, PRED& pred,
+                             std::vector<unsigned char>& mask)
+        {
+            auto its = std::make_tuple(
+                    view.template begin<find_idx<
+                            typename VIEW::fields_typelist,
+                            typename std::remove_cv<
+                                    typename std::remove_reference<
+                                            ARGS>::type>::type>::value>()...);
+            for (std::size_t i = 0; i < mask.size();
+                 ++i, nop((++std::get<IDXS>(its), 0)...)) {
+                mask[i] = MATCH == bool(pred(ARGS(*std::get<IDXS>(its))...));
+            }
+        }
+        /// compact a column of trivial type: branchless left-pack
+        template <typename IT>
+        typename std::enable_if<std::is_trivial<
+                typename std::iterator_traits<IT>::value_type>::value>::type
+        compact_column(IT col, const std::vector<unsigned char>& keep,
+                       std::size_t start)
+        {
+            // always copy, but only advance the output if the element stays
+            for (std::size_t i = start, j = start; i < keep.size(); ++i) {
+                col[j] = col[i];
+                j += keep[i];
+            }
+        }
+        /// compact a column of non-trivial type
+        template <typename IT>
+        typename std::enable_if<!std::is_trivial<
+                typename std::iterator_traits<IT>::value_type>::value>::type
+        compact_column(IT col, const std::vector<unsigned char>& keep,
+                       std::size_t start)
+        {
+            for (std::size_t i = start, j = start; i < keep.size(); ++i) {
+                if (keep[i]) col[j++] = std::move(col[i]);
+            }
+        }
+        /// compact all columns of a view
+        template <typename VIEW, std::size_t... IDXS>
+        void compact_columns(VIEW& view,
+                             const std::vector<unsigned char>& keep,
+                             std::size_t start,
+                             std::index_sequence<IDXS...> /* unused */)
+        {
+            nop((compact_column(view.template begin<IDXS>(), keep, start),
+                 0)...);
+        }
+    } // namespace impl_algs
+
+    /** @brief erase all elements of a container for which pred is true
+     *
+     * @param c             container from which to erase elements
+     * @param pred          predicate
+     *
+     * @returns number of elements erased
+     *
+     * The predicate's arguments select the fields it needs, just like for
+     * for_each, and only those columns are read to work out which
+     * elements to keep. Each column is then compacted on its own in a
+     * single pass, starting from the first element to be erased, and the
+     * container is shrunk to size. The relative order of the remaining
+     * elements is preserved.
+     *
+     * Example:
+     * @code
+     * auto c = get_some_container();
+     * // remove all tracks with low transverse momentum
+     * SOA::erase_if(c, [] (SOA::cref<f_pt> pt) { return pt < 500.f; });
+     * @endcode
+     */
+    template <typename CONTAINER, typename PRED>
+    typename CONTAINER::size_type erase_if(CONTAINER& c, PRED pred)
+    {
+        using arg_typelist =
+                typename SOA::impl_algs::callable_info<PRED>::arg_typelist;
+        static_assert(
+                decltype(SOA::impl_algs::canFindArgs(
+                        std::declval<const CONTAINER&>(),
+                        arg_typelist()))::value,
+                "some predicate arguments not found in container");
+        static_assert(
+                decltype(SOA::impl_algs::uniqueArgs(
+                        std::declval<const CONTAINER&>(),
+                        arg_typelist()))::value,
+                "unable to uniquely match all arguments "
+                "- try using tagged types as argunents");
+        std::vector<unsigned char> keep(c.size());
+        SOA::impl_algs::_predicate_mask<false>(
+                std::make_index_sequence<arg_typelist::size()>(),
+                arg_typelist(), c, pred, keep);
+        // elements before the first one to go stay where they are
+        const std::size_t start = std::find(keep.begin(), keep.end(), 0) -
+                                  keep.begin();
+        const std::size_t kept =
+                start + std::count(keep.begin() + start, keep.end(), 1);
+        if (kept == keep.size()) return 0;
+        SOA::impl_algs::compact_columns(
+                c, keep, start,
+                std::make_index_sequence<
+                        CONTAINER::fields_typelist::size()>());
+        c.erase(c.begin() + kept, c.end());
+        return keep.size() - kept;
+    }
+
+    namespace impl_algs {
+        /// how far ahead to prefetch on the random access side
+        constexpr std::size_t prefetch_distance = 16;
+        /// dst[i] = src[idx[i]] for a single column
+        template <typename SRC, typename IDXCONT, typename DST>
+        void gather_column(SRC src, const IDXCONT& idx, DST dst)
+        {
+            const std::size_t n = idx.size(),
+                              m = n > prefetch_distance
+                                          ? n - prefetch_distance
+                                          : 0;
+            std::size_t i = 0;
+            for (; i < m; ++i) {
+                SOA_PREFETCH(&src[idx[i + prefetch_distance]], 0);
+                dst[i] = src[idx[i]];
+            }
+            for (; i < n; ++i) dst[i] = src[idx[i]];
+        }
+        /// dst[idx[i]] = src[i] for a single column
+        template <typename SRC, typename IDXCONT, typename DST>
+        void scatter_column(SRC src, const IDXCONT& idx, DST dst)
+        {
+            const std::size_t n = idx.size(),
+                              m = n > prefetch_distance
+                                          ? n - prefetch_distance
+                                          : 0;
+            std::size_t i = 0;
+            for (; i < m; ++i) {
+                SOA_PREFETCH(&dst[idx[i + prefetch_distance]], 1);
+                dst[idx[i]] = src[i];
+            }
+            for (; i < n; ++i) dst[idx[i]] = src[i];
+        }
+        /// gather all columns of dst from view
+        template <typename VIEW, typename IDXCONT, typename DEST,
+                  std::size_t... IDXS>
+        void _gather(const VIEW& view, const IDXCONT& idx, DEST& dest,
+                     std::index_sequence<IDXS...> /* unused */)
+        {
+            using from = typename DEST::fields_typelist;
+            using to = typename VIEW::fields_typelist;
+            using SOA::Typelist::map_index;
+            static_assert(SOA::Utils::ALL(map_index<from, to, IDXS>() <
+                                          to::size()...),
+                          "source view lacks some destination fields");
+            nop((gather_column(
+                         view.template begin<
+                                 map_index<from, to, IDXS>()>(),
+                         idx, dest.template begin<IDXS>()),
+                 0)...);
+        }
+        /// scatter all columns of view into dest
+        template <typename VIEW, typename IDXCONT, typename DEST,
+                  std::size_t... IDXS>
+        void _scatter(const VIEW& view, const IDXCONT& idx, DEST& dest,
+                      std::index_sequence<IDXS...> /* unused */)
+        {
+            using from = typename VIEW::fields_typelist;
+            using to = typename DEST::fields_typelist;
+            using SOA::Typelist::map_index;
+            static_assert(SOA::Utils::ALL(map_index<from, to, IDXS>() <
+                                          to::size()...),
+                          "destination lacks some source view fields");
+            nop((scatter_column(view.template begin<IDXS>(), idx,
+                                dest.template begin<
+                                        map_index<from, to, IDXS>()>()),
+                 0)...);
+        }
+        /// container type to gather into (declaration only)
+        template <template <class...> class CONTAINER, typename STORAGE,
+                  template <typename> class SKIN, typename... FIELDS>
+        SOA::Container<CONTAINER, SKIN, FIELDS...>
+        gathered_type(const SOA::_View<STORAGE, SKIN, FIELDS...>*);
+    } // namespace impl_algs
+
+    /** @brief gather elements of a view by index into another view
+     *
+     * @param view          view (or container) to gather from
+     * @param indices       indices of elements in view to gather
+     * @param dest          view (or container) to write to (must have at
+     *                      least indices.size() elements)
+     *
+     * Sets dest[i] = view[indices[i]] for all i. This works one column at
+     * a time, so every column of dest is streamed through exactly once,
+     * and the random reads from view are prefetched. dest may have fewer
+     * fields than view (fields are matched by position if the field lists
+     * agree, and by field otherwise).
+     */
+    template <typename VIEW, typename IDXCONT, typename DEST>
+    void gather(const VIEW& view, const IDXCONT& indices, DEST&& dest)
+    {
+        using dest_type = typename std::remove_reference<DEST>::type;
+        assert(dest.size() >= indices.size());
+        SOA::impl_algs::_gather(
+                view, indices, dest,
+                std::make_index_sequence<
+                        dest_type::fields_typelist::size()>());
+    }
+
+    /** @brief gather elements of a view by index into a new container
+     *
+     * @tparam CONTAINER    (optional) underlying container type used for
+     *                      returned container
+     * @param view          view (or container) to gather from
+     * @param indices       indices of elements in view to gather
+     *
+     * @returns container c with c[i] = view[indices[i]] for all i
+     *
+     * Example:
+     * @code
+     * auto hits = get_hits();
+     * std::vector<std::size_t> onTrack = get_hit_indices(track);
+     * auto trackHits = SOA::gather(hits, onTrack);
+     * @endcode
+     */
+    template <template <class...> class CONTAINER = std::vector,
+              typename VIEW, typename IDXCONT>
+    auto gather(const VIEW& view, const IDXCONT& indices)
+            -> decltype(SOA::impl_algs::gathered_type<CONTAINER>(&view))
+    {
+        decltype(SOA::impl_algs::gathered_type<CONTAINER>(&view)) retVal;
+        SOA::impl_algs::resize_for_overwrite(retVal, indices.size());
+        gather(view, indices, retVal);
+        return retVal;
+    }
+
+    /** @brief scatter elements of a view to the given indices of another
+     *
+     * @param view          view (or container) to scatter from
+     * @param indices       indices in dest to write to (one per element
+     *                      of view)
+     * @param dest          view (or container) to write to
+     *
+     * Sets dest[indices[i]] = view[i] for all i. Like gather, this works one
+     * column at a time, and the random writes to dest are prefetched. dest
+     * may have more fields than view; those are left alone.
+     */
+    template <typename VIEW, typename IDXCONT, typename DEST>
+    void scatter(const VIEW& view, const IDXCONT& indices, DEST&& dest)
+    {
+        assert(view.size() == indices.size());
+        SOA::impl_algs::_scatter(
+                view, indices, dest,
+                std::make_index_sequence<VIEW::fields_typelist::size()>());
     }
 } // namespace SOA
 
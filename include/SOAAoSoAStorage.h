@@ -0,0 +1,674 @@
+/** @file SOAAoSoAStorage.h
+ *
+ * @brief storage policy for tiled ("array of structures of arrays") layout
+ *
+ * For copyright and license information, see the end of the file.
+ */
+#ifndef SOAAOSOASTORAGE_H
+#define SOAAOSOASTORAGE_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "AlignedAllocator.h"
+#include "SOATypelist.h"
+#include "SOATypelistUtils.h"
+#include "c++14_compat.h"
+
+namespace SOA {
+    namespace impl {
+        /// tag type naming a column of an AoSoA storage (never defined)
+        template <std::size_t W, typename... T>
+        struct aosoa_tag;
+
+        /// round n up to a multiple of a
+        constexpr std::size_t aosoa_round_up(std::size_t n,
+                                             std::size_t a) noexcept
+        { return (n + a - 1) / a * a; }
+        /// maximum of a list of sizes
+        constexpr std::size_t aosoa_max(std::size_t a) noexcept { return a; }
+        template <typename... SZ>
+        constexpr std::size_t aosoa_max(std::size_t a, std::size_t b,
+                                        SZ... sz) noexcept
+        { return aosoa_max(a < b ? b : a, sz...); }
+
+        /// offset of the tile of field IDX inside a block
+        template <std::size_t W, typename TL, std::size_t IDX>
+        struct aosoa_tile_offset
+                : std::integral_constant<
+                          std::size_t,
+                          aosoa_round_up(
+                                  aosoa_tile_offset<W, TL, IDX - 1>::value +
+                                          W * sizeof(typename TL::template at<
+                                                     IDX - 1>::type),
+                                  alignof(typename TL::template at<
+                                          IDX>::type))> {};
+        /// first tile starts at the beginning of the block
+        template <std::size_t W, typename TL>
+        struct aosoa_tile_offset<W, TL, 0>
+                : std::integral_constant<std::size_t, 0> {};
+
+        /// layout of a block of W elements of all fields in TL
+        template <std::size_t W, typename TL>
+        struct aosoa_layout;
+        template <std::size_t W, typename... ALL>
+        struct aosoa_layout<W, SOA::Typelist::typelist<ALL...> > {
+            using fields = SOA::Typelist::typelist<ALL...>;
+            /// offset of tile of field IDX inside a block
+            template <std::size_t IDX>
+            using offset = aosoa_tile_offset<W, fields, IDX>;
+            enum : std::size_t {
+                /// size of a block of W elements (all fields)
+                block_size = aosoa_round_up(
+                        offset<sizeof...(ALL) - 1>::value +
+                                W * sizeof(typename fields::template at<
+                                           sizeof...(ALL) - 1>::type),
+                        aosoa_max(alignof(ALL)...))
+            };
+        };
+
+        /** @brief iterator over one field in AoSoA storage
+         *
+         * Element idx lives in block idx / W, at position idx % W inside
+         * that field's tile. W is a power of two, so this is cheap. The
+         * tiles themselves are contiguous, see tile().
+         */
+        template <typename T, std::size_t W, std::size_t BLOCK,
+                  std::size_t OFF>
+        class aosoa_iterator {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = typename std::remove_cv<T>::type;
+            using difference_type = std::ptrdiff_t;
+            using size_type = std::size_t;
+            using reference = T&;
+            using pointer = T*;
+            enum : std::size_t { tile_size = W };
+
+        private:
+            template <typename U, std::size_t, std::size_t, std::size_t>
+            friend class aosoa_iterator;
+            using byte_pointer = typename std::conditional<
+                    std::is_const<T>::value, const char*, char*>::type;
+
+            byte_pointer m_base = nullptr; ///< start of first block
+            difference_type m_idx = 0;     ///< element index
+
+            pointer address(difference_type idx) const noexcept
+            {
+                const size_type i = idx;
+                return reinterpret_cast<pointer>(m_base + (i / W) * BLOCK +
+                                                 OFF) + i % W;
+            }
+
+        public:
+            aosoa_iterator() = default;
+            aosoa_iterator(byte_pointer base, difference_type idx) noexcept
+                    : m_base(base), m_idx(idx)
+            {}
+            /// convert iterator to iterator over const
+            template <typename U, typename = typename std::enable_if<
+                                          std::is_same<const U, T>::value &&
+                                          !std::is_same<U, T>::value>::type>
+            aosoa_iterator(
+                    const aosoa_iterator<U, W, BLOCK, OFF>& other) noexcept
+                    : m_base(other.m_base), m_idx(other.m_idx)
+            {}
+
+            reference operator*() const noexcept { return *address(m_idx); }
+            pointer operator->() const noexcept { return address(m_idx); }
+            reference operator[](difference_type n) const noexcept
+            { return *address(m_idx + n); }
+            /// start of the (contiguous) tile containing this element
+            pointer tile() const noexcept
+            { return address(m_idx & ~difference_type(W - 1)); }
+            /// position of this element inside its tile
+            size_type lane() const noexcept { return m_idx & (W - 1); }
+
+            aosoa_iterator& operator++() noexcept { ++m_idx; return *this; }
+            aosoa_iterator& operator--() noexcept { --m_idx; return *this; }
+            aosoa_iterator operator++(int) noexcept
+            { aosoa_iterator retVal(*this); ++m_idx; return retVal; }
+            aosoa_iterator operator--(int) noexcept
+            { aosoa_iterator retVal(*this); --m_idx; return retVal; }
+            aosoa_iterator& operator+=(difference_type n) noexcept
+            { m_idx += n; return *this; }
+            aosoa_iterator& operator-=(difference_type n) noexcept
+            { m_idx -= n; return *this; }
+            aosoa_iterator operator+(difference_type n) const noexcept
+            { return aosoa_iterator(m_base, m_idx + n); }
+            aosoa_iterator operator-(difference_type n) const noexcept
+            { return aosoa_iterator(m_base, m_idx - n); }
+            friend aosoa_iterator operator+(difference_type n,
+                                            const aosoa_iterator& it) noexcept
+            { return it + n; }
+            difference_type operator-(const aosoa_iterator& other) const
+                    noexcept
+            { return m_idx - other.m_idx; }
+
+            bool operator==(const aosoa_iterator& other) const noexcept
+            { return m_idx == other.m_idx && m_base == other.m_base; }
+            bool operator!=(const aosoa_iterator& other) const noexcept
+            { return !(*this == other); }
+            bool operator<(const aosoa_iterator& other) const noexcept
+            { return m_idx < other.m_idx; }
+            bool operator>(const aosoa_iterator& other) const noexcept
+            { return other < *this; }
+            bool operator<=(const aosoa_iterator& other) const noexcept
+            { return !(other < *this); }
+            bool operator>=(const aosoa_iterator& other) const noexcept
+            { return !(*this < other); }
+        };
+
+        template <typename... COLUMNS>
+        class aosoa_storage;
+        template <std::size_t W, std::size_t IDX, typename TL>
+        class aosoa_column;
+
+        /// storage type for fields in TL, tile width W
+        template <std::size_t W, typename TL,
+                  typename SEQ = decltype(
+                          std::make_index_sequence<TL::size()>())>
+        struct aosoa_storage_of;
+        template <std::size_t W, typename TL, std::size_t... IDX>
+        struct aosoa_storage_of<W, TL, std::index_sequence<IDX...> > {
+            using type = aosoa_storage<aosoa_column<W, IDX, TL>...>;
+        };
+
+        /** @brief one field of an aosoa_storage
+         *
+         * The column looks like a std::vector to SOA::Container, but
+         * elements are stored in tiles of W elements, interleaved with the
+         * tiles of the other fields. Capacity is managed by the storage,
+         * so columns cannot be copied or moved on their own.
+         */
+        template <std::size_t W, std::size_t IDX, typename... ALL>
+        class aosoa_column<W, IDX, SOA::Typelist::typelist<ALL...> > {
+        private:
+            using layout = aosoa_layout<W, SOA::Typelist::typelist<ALL...> >;
+
+        public:
+            using value_type = typename SOA::Typelist::typelist<
+                    ALL...>::template at<IDX>::type;
+            using size_type = std::size_t;
+            using difference_type = std::ptrdiff_t;
+            using reference = value_type&;
+            using const_reference = const value_type&;
+            using pointer = value_type*;
+            using const_pointer = const value_type*;
+            using iterator = aosoa_iterator<value_type, W, layout::block_size,
+                                            layout::template offset<
+                                                    IDX>::value>;
+            using const_iterator =
+                    aosoa_iterator<const value_type, W, layout::block_size,
+                                   layout::template offset<IDX>::value>;
+            using reverse_iterator = std::reverse_iterator<iterator>;
+            using const_reverse_iterator =
+                    std::reverse_iterator<const_iterator>;
+            enum : std::size_t {
+                tile_size = W, ///< number of elements in a tile
+                block_size = layout::block_size, ///< bytes per block
+                /// offset of this field's tile in a block
+                tile_offset = layout::template offset<IDX>::value
+            };
+
+        private:
+            static_assert(std::is_trivial<value_type>::value,
+                          "SOA::AoSoA requires trivial field types");
+            template <typename... COLUMNS>
+            friend class aosoa_storage;
+            /// type of the storage this column lives in
+            using storage_type = typename aosoa_storage_of<
+                    W, SOA::Typelist::typelist<ALL...> >::type;
+
+            size_type m_size = 0;             ///< number of elements
+            storage_type* m_parent = nullptr; ///< storage owning the column
+
+            /// value-initialise a temporary
+            static value_type make() noexcept { return value_type(); }
+            /// construct a temporary from arguments
+            template <typename A, typename... ARGS>
+            static value_type make(A&& a, ARGS&&... args)
+            {
+                value_type val(std::forward<A>(a),
+                               std::forward<ARGS>(args)...);
+                return val;
+            }
+
+            /// open a gap of cnt elements at idx, return start of gap
+            iterator open_gap(size_type idx, size_type cnt)
+            {
+                assert(idx <= m_size);
+                if (m_size + cnt > capacity()) m_parent->grow(m_size + cnt);
+                std::copy_backward(begin() + idx, end(), end() + cnt);
+                m_size += cnt;
+                return begin() + idx;
+            }
+
+        public:
+            aosoa_column() = default;
+            aosoa_column(const aosoa_column&) = delete;
+            aosoa_column(aosoa_column&&) = delete;
+            aosoa_column& operator=(const aosoa_column&) = delete;
+            aosoa_column& operator=(aosoa_column&&) = delete;
+
+            iterator begin() noexcept { return {m_parent->m_buf, 0}; }
+            const_iterator begin() const noexcept
+            { return {m_parent->m_buf, 0}; }
+            const_iterator cbegin() const noexcept { return begin(); }
+            iterator end() noexcept
+            { return {m_parent->m_buf, difference_type(m_size)}; }
+            const_iterator end() const noexcept
+            { return {m_parent->m_buf, difference_type(m_size)}; }
+            const_iterator cend() const noexcept { return end(); }
+            reverse_iterator rbegin() noexcept
+            { return reverse_iterator(end()); }
+            const_reverse_iterator rbegin() const noexcept
+            { return const_reverse_iterator(end()); }
+            const_reverse_iterator crbegin() const noexcept
+            { return const_reverse_iterator(end()); }
+            reverse_iterator rend() noexcept
+            { return reverse_iterator(begin()); }
+            const_reverse_iterator rend() const noexcept
+            { return const_reverse_iterator(begin()); }
+            const_reverse_iterator crend() const noexcept
+            { return const_reverse_iterator(begin()); }
+
+            /// pointer to the W contiguous elements of tile (block) blk
+            pointer tile(size_type blk) noexcept
+            {
+                return reinterpret_cast<pointer>(
+                        m_parent->m_buf + blk * block_size + tile_offset);
+            }
+            /// pointer to the W contiguous elements of tile (block) blk
+            const_pointer tile(size_type blk) const noexcept
+            {
+                return reinterpret_cast<const_pointer>(
+                        m_parent->m_buf + blk * block_size + tile_offset);
+            }
+            /// number of (possibly partially filled) tiles
+            size_type tiles() const noexcept
+            { return (m_size + W - 1) / W; }
+
+            size_type size() const noexcept { return m_size; }
+            bool empty() const noexcept { return !m_size; }
+            size_type capacity() const noexcept
+            { return m_parent->capacity(); }
+            size_type max_size() const noexcept
+            { return m_parent->max_size(); }
+
+            reference operator[](size_type idx) noexcept
+            { return begin()[idx]; }
+            const_reference operator[](size_type idx) const noexcept
+            { return begin()[idx]; }
+            reference at(size_type idx)
+            {
+                if (idx >= m_size)
+                    throw std::out_of_range("out of bounds");
+                return begin()[idx];
+            }
+            const_reference at(size_type idx) const
+            {
+                if (idx >= m_size)
+                    throw std::out_of_range("out of bounds");
+                return begin()[idx];
+            }
+            reference front() noexcept { return *begin(); }
+            const_reference front() const noexcept { return *begin(); }
+            reference back() noexcept { return end()[-1]; }
+            const_reference back() const noexcept { return end()[-1]; }
+
+            /// reserve room for n elements (in all columns)
+            void reserve(size_type n) { m_parent->reserve(n); }
+            /// shrink the storage to fit the contents
+            void shrink_to_fit() { m_parent->shrink_to_fit(); }
+            void clear() noexcept { m_size = 0; }
+            void pop_back() noexcept
+            {
+                assert(m_size);
+                --m_size;
+            }
+
+            template <typename... ARGS>
+            reference emplace_back(ARGS&&... args)
+            {
+                // construct first, args may refer to an element of ours
+                const value_type val(make(std::forward<ARGS>(args)...));
+                if (m_size == capacity()) m_parent->grow(m_size + 1);
+                pointer p = &*end();
+                ::new (static_cast<void*>(p)) value_type(val);
+                ++m_size;
+                return *p;
+            }
+            /// append, caller guarantees that size() < capacity()
+            template <typename... ARGS>
+            reference emplace_back_unchecked(ARGS&&... args)
+            {
+                assert(m_size < capacity());
+                pointer p = &*end();
+                ::new (static_cast<void*>(p))
+                        value_type(make(std::forward<ARGS>(args)...));
+                ++m_size;
+                return *p;
+            }
+            void push_back(const value_type& val) { emplace_back(val); }
+            void push_back(value_type&& val) { emplace_back(std::move(val)); }
+
+            iterator insert(const_iterator pos, size_type cnt,
+                            const value_type& val)
+            {
+                const value_type tmp(val);
+                iterator it = open_gap(pos - cbegin(), cnt);
+                std::fill(it, it + cnt, tmp);
+                return it;
+            }
+            iterator insert(const_iterator pos, const value_type& val)
+            { return insert(pos, 1, val); }
+            iterator insert(const_iterator pos, value_type&& val)
+            { return insert(pos, 1, val); }
+            /// insert range [first, last) (must not point into this column)
+            template <typename IT,
+                      typename = typename std::enable_if<
+                              !std::is_integral<IT>::value>::type>
+            iterator insert(const_iterator pos, IT first, IT last)
+            {
+                iterator it = open_gap(pos - cbegin(),
+                                       std::distance(first, last));
+                std::copy(first, last, it);
+                return it;
+            }
+            template <typename... ARGS>
+            iterator emplace(const_iterator pos, ARGS&&... args)
+            { return insert(pos, 1, make(std::forward<ARGS>(args)...)); }
+
+            iterator erase(const_iterator first, const_iterator last) noexcept
+            {
+                iterator it = begin() + (first - cbegin());
+                const size_type cnt = last - first;
+                std::copy(it + cnt, end(), it);
+                m_size -= cnt;
+                return it;
+            }
+            iterator erase(const_iterator pos) noexcept
+            { return erase(pos, pos + 1); }
+
+            void resize(size_type sz, const value_type& val)
+            {
+                if (sz > m_size) {
+                    const value_type tmp(val);
+                    if (sz > capacity()) m_parent->grow(sz);
+                    std::fill(end(), begin() + sz, tmp);
+                }
+                m_size = sz;
+            }
+            void resize(size_type sz) { resize(sz, value_type()); }
+            /// resize, leaving new elements uninitialised
+            void resize_default_init(size_type sz)
+            {
+                if (sz > capacity()) m_parent->grow(sz);
+                m_size = sz;
+            }
+            void assign(size_type cnt, const value_type& val)
+            {
+                const value_type tmp(val);
+                m_size = 0;
+                resize(cnt, tmp);
+            }
+        };
+
+        /** @brief storage for SOA::AoSoA backed containers
+         *
+         * A tuple of columns (so std::get and friends work), all of which
+         * live in a single buffer of blocks. Block b holds elements
+         * [b * W, (b + 1) * W) of all fields, one contiguous tile per field.
+         * Capacity is always a multiple of W, so kernels may process whole
+         * tiles, including the unused lanes of the last one.
+         */
+        template <typename... COLUMNS>
+        class aosoa_storage : public std::tuple<COLUMNS...> {
+        public:
+            using size_type = std::size_t;
+
+        private:
+            template <std::size_t W, std::size_t IDX, typename TL>
+            friend class aosoa_column;
+            using base_type = std::tuple<COLUMNS...>;
+            using first_column =
+                    typename std::tuple_element<0, base_type>::type;
+            using indices =
+                    decltype(std::make_index_sequence<sizeof...(COLUMNS)>());
+            enum : size_type {
+                tile_size = first_column::tile_size,
+                block_size = first_column::block_size,
+                alignment = 64
+            };
+            using allocator_type = SOA::AlignedAllocator<char, alignment>;
+
+            char* m_buf = nullptr;    ///< the blocks
+            size_type m_capacity = 0; ///< capacity of all columns
+            double m_growth = 2.;     ///< geometric growth factor
+
+            base_type& base() noexcept { return *this; }
+            const base_type& base() const noexcept { return *this; }
+
+            /// number of blocks needed for n elements
+            constexpr static size_type blocks(size_type n) noexcept
+            { return (n + tile_size - 1) / tile_size; }
+            /// number of elements in the longest column
+            size_type used() const noexcept { return used(indices()); }
+            template <std::size_t... IDX>
+            size_type used(std::index_sequence<IDX...>) const noexcept
+            { return std::max({std::get<IDX>(base()).m_size...}); }
+
+            /// make columns point back at this storage
+            template <std::size_t... IDX>
+            void attach(std::index_sequence<IDX...>) noexcept
+            {
+                (void) std::initializer_list<int>{
+                        (std::get<IDX>(base()).m_parent = this, 0)...};
+            }
+            template <std::size_t... IDX>
+            void copy_sizes(const aosoa_storage& other,
+                            std::index_sequence<IDX...>) noexcept
+            {
+                (void) std::initializer_list<int>{
+                        (std::get<IDX>(base()).m_size =
+                                 std::get<IDX>(other.base()).m_size,
+                         0)...};
+            }
+            template <std::size_t... IDX>
+            void swap_sizes(aosoa_storage& other,
+                            std::index_sequence<IDX...>) noexcept
+            {
+                (void) std::initializer_list<int>{
+                        (std::swap(std::get<IDX>(base()).m_size,
+                                   std::get<IDX>(other.base()).m_size),
+                         0)...};
+            }
+
+            /// move contents to new buffer with capacity newcap
+            void reallocate(size_type newcap)
+            {
+                assert(newcap >= used());
+                newcap = blocks(newcap) * tile_size;
+                char* buf = newcap ? allocator_type().allocate(
+                                             blocks(newcap) * block_size)
+                                   : nullptr;
+                // block layout does not depend on capacity: one memcpy
+                const size_type nbytes = blocks(used()) * block_size;
+                if (nbytes) std::memcpy(buf, m_buf, nbytes);
+                release();
+                m_buf = buf;
+                m_capacity = newcap;
+            }
+            /// grow so that at least n elements fit (geometrically)
+            void grow(size_type n)
+            { reallocate(std::max(n, size_type(m_capacity * m_growth))); }
+            /// free the buffer
+            void release() noexcept
+            {
+                if (m_buf)
+                    allocator_type().deallocate(
+                            m_buf, blocks(m_capacity) * block_size);
+            }
+
+        public:
+            aosoa_storage() : base_type() { attach(indices()); }
+            aosoa_storage(const aosoa_storage& other) :
+                base_type(), m_growth(other.m_growth)
+            {
+                attach(indices());
+                reserve(other.used());
+                const size_type nbytes = blocks(other.used()) * block_size;
+                if (nbytes) std::memcpy(m_buf, other.m_buf, nbytes);
+                copy_sizes(other, indices());
+            }
+            aosoa_storage(aosoa_storage&& other) noexcept : base_type()
+            {
+                attach(indices());
+                swap(other);
+            }
+            ~aosoa_storage() { release(); }
+
+            aosoa_storage& operator=(const aosoa_storage& other)
+            {
+                if (this != &other) {
+                    aosoa_storage tmp(other);
+                    swap(tmp);
+                }
+                return *this;
+            }
+            aosoa_storage& operator=(aosoa_storage&& other) noexcept
+            {
+                if (this != &other) {
+                    aosoa_storage tmp(std::move(other));
+                    swap(tmp);
+                }
+                return *this;
+            }
+            /// exchange contents with other
+            void swap(aosoa_storage& other) noexcept
+            {
+                std::swap(m_buf, other.m_buf);
+                std::swap(m_capacity, other.m_capacity);
+                std::swap(m_growth, other.m_growth);
+                swap_sizes(other, indices());
+            }
+
+            /// capacity (shared by all columns, multiple of tile size)
+            size_type capacity() const noexcept { return m_capacity; }
+            /// maximum number of elements
+            size_type max_size() const noexcept
+            {
+                return std::numeric_limits<size_type>::max() / block_size *
+                       tile_size;
+            }
+            /// factor by which columns grow when they run out of space
+            void set_growth_factor(double factor) noexcept
+            { m_growth = factor; }
+            /// make room for n elements in all columns at once
+            void reserve(size_type n)
+            {
+                if (n > max_size()) throw std::length_error("too large");
+                if (n > m_capacity) reallocate(n);
+            }
+            /// free unused capacity (down to the next full tile)
+            void shrink_to_fit()
+            {
+                const size_type n = blocks(used()) * tile_size;
+                if (n < m_capacity) reallocate(n);
+            }
+        };
+
+        /// swap two aosoa_storages
+        template <typename... COLUMNS>
+        void swap(aosoa_storage<COLUMNS...>& a,
+                  aosoa_storage<COLUMNS...>& b) noexcept
+        { a.swap(b); }
+    } // namespace impl
+
+    /** @brief storage policy: tiled ("AoSoA") layout with tile width W
+     *
+     * Elements are stored in blocks of W elements: W elements of the first
+     * field, then W elements of the second field, and so on, then the next
+     * block. Use the nested storage template as the first template
+     * argument of SOA::Container:
+     *
+     * @code
+     * SOA::Container<SOA::AoSoA<8>::storage, SOAPointSkin> points;
+     * // process a full tile of x at a time
+     * for (auto it = points.begin<f_x>(); it < points.end<f_x>(); it += 8) {
+     *     float* x = it.tile(); // 8 contiguous x values
+     *     // ...
+     * }
+     * @endcode
+     *
+     * The skin interface and proxy semantics are the same as for any other
+     * SOA::Container. All fields of an element are within a block, so
+     * kernels touching many fields need few memory streams, while each
+     * tile is contiguous and can be vectorised. Fields must be trivial
+     * types, and W must be a power of two.
+     */
+    template <std::size_t W>
+    struct AoSoA {
+        static_assert(W && !(W & (W - 1)), "W must be a power of two");
+        template <typename... T>
+        using storage = impl::aosoa_tag<W, T...>;
+    };
+
+    namespace Typelist {
+        namespace _to_tuple_impl {
+            /// AoSoA: all columns managed by a single aosoa_storage
+            template <std::size_t W, typename... ARGS>
+            struct select_column_storage<SOA::impl::aosoa_tag<W, ARGS>...> {
+                using _t = typename SOA::impl::aosoa_storage_of<
+                        W, typelist<ARGS...> >::type;
+            };
+        } // namespace _to_tuple_impl
+    } // namespace Typelist
+} // namespace SOA
+
+namespace std {
+    /// aosoa_storage behaves like a tuple of its columns
+    template <typename... COLUMNS>
+    struct tuple_size<SOA::impl::aosoa_storage<COLUMNS...> >
+            : std::integral_constant<std::size_t, sizeof...(COLUMNS)> {};
+    /// aosoa_storage behaves like a tuple of its columns
+    template <std::size_t IDX, typename... COLUMNS>
+    struct tuple_element<IDX, SOA::impl::aosoa_storage<COLUMNS...> >
+            : std::tuple_element<IDX, std::tuple<COLUMNS...> > {};
+} // namespace std
+
+#endif // SOAAOSOASTORAGE_H
+
+/* Copyright (C) CERN for the benefit of the LHCb collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In applying this licence, CERN does not waive the privileges and immunities
+ * granted to it by virtue of its status as an Intergovernmental Organization
+ * or submit itself to any jurisdiction.
+ */
+
+// vim: sw=4:tw=78:ft=cpp:et
@@ -0,0 +1,296 @@
+/** @file SOACellList.h
+ *
+ * @brief uniform grid (cell list) spatial index over SOA views
+ *
+ * For copyright and license information, see the end of the file.
+ */
+#ifndef SOACELLLIST_H
+#define SOACELLLIST_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "c++14_compat.h"
+#include "SOATypelist.h"
+#include "SOAAlgorithms.h"
+
+namespace SOA {
+    /** @brief uniform grid over the position fields of a view
+     *
+     * @tparam FIELDS       position fields (one per dimension, the first
+     *                      one varies fastest from cell to cell)
+     *
+     * Building the cell list sorts the view by cell with a (stable)
+     * counting sort, moving each column into place in one pass. Afterwards,
+     * the rows in each cell are contiguous, and so are the rows in
+     * neighbouring cells along the first dimension. A neighbour search
+     * around a point thus needs to look at only a few contiguous ranges of
+     * rows instead of scanning the full view.
+     *
+     * Example:
+     * @code
+     * // hits is a container with fields f_x and f_y
+     * SOA::CellList<f_x, f_y> grid(hits, 2.f * maxdist);
+     * grid.for_each_neighbour_range({{x, y}},
+     *         [&] (std::size_t first, std::size_t last) {
+     *             for (auto i = first; i != last; ++i)
+     *                 if (close(hits[i], x, y)) use(hits[i]);
+     *         });
+     * @endcode
+     *
+     * The row numbers refer to the view as reordered by the constructor;
+     * the cell list is no longer valid once rows are inserted, removed, or
+     * moved around.
+     */
+    template <typename... FIELDS>
+    class CellList {
+    public:
+        /// number of dimensions
+        static constexpr std::size_t dim = sizeof...(FIELDS);
+        static_assert(dim > 0, "need at least one position field");
+        /// coordinate type
+        using value_type = typename std::common_type<
+                SOA::Typelist::unwrap_t<FIELDS>...>::type;
+        static_assert(std::is_floating_point<value_type>::value,
+                      "position fields must be floating point");
+        /// a position
+        using point_type = std::array<value_type, dim>;
+
+    private:
+        /// cap on the number of cells (per row in the view)
+        static constexpr std::size_t cells_per_row = 4;
+        /// cap on the number of steps to enlarge cells
+        static constexpr unsigned max_grow_steps = 256;
+
+        point_type m_lo;
+        value_type m_cellsize;
+        std::array<std::size_t, dim> m_ncells;
+        /// rows of cell c are [m_start[c], m_start[c + 1])
+        std::vector<std::size_t> m_start;
+
+        /// position of row i of view
+        template <typename VIEW>
+        static point_type position(VIEW& view, std::size_t i)
+        {
+            return point_type{{value_type(
+                    view.template begin<FIELDS>()[i])...}};
+        }
+
+        /// x is neither infinite nor NaN (by bit pattern: -ffast-math safe)
+        static bool finite(float x) noexcept
+        {
+            std::uint32_t u;
+            std::memcpy(&u, &x, sizeof(x));
+            return (u & 0x7f800000u) != 0x7f800000u;
+        }
+        /// x is neither infinite nor NaN (by bit pattern: -ffast-math safe)
+        static bool finite(double x) noexcept
+        {
+            std::uint64_t u;
+            std::memcpy(&u, &x, sizeof(x));
+            return (u & 0x7ff0000000000000u) != 0x7ff0000000000000u;
+        }
+        /// x is neither infinite nor NaN
+        static bool finite(long double x) noexcept
+        { return finite(double(x)); }
+
+        /// position of row i of view, throws for non-finite coordinates
+        template <typename VIEW>
+        static point_type checked_position(VIEW& view, std::size_t i)
+        {
+            const point_type p = position(view, i);
+            for (std::size_t d = 0; d < dim; ++d) {
+                if (!finite(p[d]))
+                    throw std::domain_error(
+                            "CellList: non-finite coordinate");
+            }
+            return p;
+        }
+
+        /// cell coordinate along dimension d (clamped to the grid)
+        std::size_t cell_coord(std::size_t d, value_type x) const noexcept
+        {
+            const value_type c = std::floor((x - m_lo[d]) / m_cellsize);
+            if (!(c > 0)) return 0;
+            const std::size_t last = m_ncells[d] - 1;
+            // compare before converting: c may exceed any std::size_t
+            if (!(c < value_type(last))) return last;
+            return std::size_t(c);
+        }
+
+        /// set up grid for cell size sz, return total number of cells
+        double ncells_for(const point_type& hi, value_type sz) noexcept
+        {
+            double total = 1;
+            for (std::size_t d = 0; d < dim; ++d) {
+                const double n = std::floor((hi[d] - m_lo[d]) / sz) + 1;
+                m_ncells[d] = std::size_t(std::min(
+                        n, double(std::numeric_limits<int>::max())));
+                total *= m_ncells[d];
+            }
+            return total;
+        }
+
+    public:
+        /** @brief build the cell list, reordering view by cell
+         *
+         * @param view          view (or container) to index; its rows are
+         *                      reordered such that rows in the same cell
+         *                      are contiguous
+         * @param cellsize      (minimum) edge length of a cell
+         *
+         * If cells of the requested size would be much more numerous than
+         * the rows of the view, the cell size is increased. Searching the
+         * neighbouring cells therefore still finds all rows within
+         * cellsize of a point. (If the coordinates span more than the
+         * range of value_type, a single cell is used.)
+         *
+         * @throws std::domain_error if a coordinate is infinite or NaN
+         */
+        template <typename VIEW>
+        CellList(VIEW&& view, value_type cellsize) : m_cellsize(cellsize)
+        {
+            const std::size_t n = view.size();
+            point_type hi;
+            m_lo.fill(0), hi.fill(0);
+            if (n) m_lo = hi = checked_position(view, 0);
+            for (std::size_t i = 1; i < n; ++i) {
+                const point_type p = checked_position(view, i);
+                for (std::size_t d = 0; d < dim; ++d) {
+                    m_lo[d] = std::min(m_lo[d], p[d]);
+                    hi[d] = std::max(hi[d], p[d]);
+                }
+            }
+            if (!(m_cellsize > 0))
+                m_cellsize = std::numeric_limits<value_type>::min();
+            const double maxcells =
+                    std::max(std::size_t(1), cells_per_row * n);
+            double total = ncells_for(hi, m_cellsize);
+            for (unsigned step = 0; maxcells < total; ++step) {
+                m_cellsize *= std::max(
+                        value_type(1.125),
+                        value_type(std::pow(total / maxcells, 1. / dim)));
+                if (max_grow_steps <= step || !finite(m_cellsize)) {
+                    // extent beyond the range of value_type: one cell
+                    m_cellsize = std::numeric_limits<value_type>::max();
+                    m_ncells.fill(1);
+                    total = 1;
+                    break;
+                }
+                total = ncells_for(hi, m_cellsize);
+            }
+            // counting sort by cell
+            std::vector<std::size_t> cells;
+            cells.reserve(n);
+            m_start.assign(std::size_t(total) + 1, 0);
+            for (std::size_t i = 0; i < n; ++i) {
+                cells.push_back(cell_index(position(view, i)));
+                ++m_start[cells.back() + 1];
+            }
+            for (std::size_t c = 1; c < m_start.size(); ++c)
+                m_start[c] += m_start[c - 1];
+            std::vector<std::size_t> perm(n);
+            {
+                std::vector<std::size_t> next(m_start.begin(),
+                                              m_start.end() - 1);
+                for (std::size_t i = 0; i < n; ++i)
+                    perm[next[cells[i]]++] = i;
+            }
+            std::vector<std::size_t>().swap(cells);
+            SOA::apply_permutation(view, perm);
+        }
+
+        /// edge length of a cell
+        value_type cell_size() const noexcept { return m_cellsize; }
+        /// number of cells
+        std::size_t ncells() const noexcept { return m_start.size() - 1; }
+        /// number of cells along dimension d
+        std::size_t ncells(std::size_t d) const noexcept
+        { return m_ncells[d]; }
+
+        /// index of the cell containing p (clamped to the grid)
+        std::size_t cell_index(const point_type& p) const noexcept
+        {
+            std::size_t idx = 0;
+            for (std::size_t d = dim; d--;)
+                idx = idx * m_ncells[d] + cell_coord(d, p[d]);
+            return idx;
+        }
+
+        /// rows [first, last) in cell c
+        std::pair<std::size_t, std::size_t> cell_rows(std::size_t c) const
+        { return std::make_pair(m_start[c], m_start[c + 1]); }
+
+        /** @brief call func(first, last) for the rows near p
+         *
+         * Calls func with contiguous ranges of rows [first, last) which,
+         * between them, contain all rows in the cell of p and its
+         * neighbouring cells, i.e. at least all rows within cell_size() of
+         * p. Adjacent cells along the first dimension are passed as a
+         * single range. Empty ranges are skipped.
+         */
+        template <typename FUNC>
+        void for_each_neighbour_range(const point_type& p,
+                                      FUNC&& func) const
+        {
+            std::array<std::size_t, dim> lo, hi, cur;
+            for (std::size_t d = 0; d < dim; ++d) {
+                const std::size_t c = cell_coord(d, p[d]);
+                lo[d] = c ? c - 1 : 0;
+                hi[d] = std::min(c + 1, m_ncells[d] - 1);
+            }
+            cur = lo;
+            // loop over the neighbouring cells in dimensions 1, ..., dim - 1
+            for (;;) {
+                std::size_t base = 0;
+                for (std::size_t d = dim; --d;)
+                    base = (base + cur[d]) * m_ncells[d - 1];
+                const std::size_t first = m_start[base + lo[0]],
+                                  last = m_start[base + hi[0] + 1];
+                if (first != last) func(first, last);
+                std::size_t d = 1;
+                for (; d < dim && cur[d] == hi[d]; ++d) cur[d] = lo[d];
+                if (d >= dim) break;
+                ++cur[d];
+            }
+        }
+    };
+
+    template <typename... FIELDS>
+    constexpr std::size_t CellList<FIELDS...>::dim;
+    template <typename... FIELDS>
+    constexpr std::size_t CellList<FIELDS...>::cells_per_row;
+} // namespace SOA
+
+#endif // SOACELLLIST_H
+
+/* Copyright (C) CERN for the benefit of the LHCb collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In applying this licence, CERN does not waive the privileges and immunities
+ * granted to it by virtue of its status as an Intergovernmental Organization
+ * or submit itself to any jurisdiction.
+ */
+
+// vim: sw=4:tw=78:ft=cpp:et
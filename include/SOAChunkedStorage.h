@@ -0,0 +1,458 @@
+/** @file SOAChunkedStorage.h
+ *
+ * @brief storage policy keeping each column in fixed-size aligned chunks
+ *
+ * For copyright and license information, see the end of the file.
+ */
+#ifndef SOACHUNKEDSTORAGE_H
+#define SOACHUNKEDSTORAGE_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "AlignedAllocator.h"
+
+namespace SOA {
+    namespace impl {
+        /** @brief iterator over a chunked_column
+         *
+         * Element idx lives in chunk idx / CHUNK, at position idx % CHUNK
+         * inside that chunk. CHUNK is a power of two, so this is cheap. The
+         * chunks themselves are contiguous, see contiguous_run().
+         */
+        template <typename T, std::size_t CHUNK>
+        class chunked_iterator {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = typename std::remove_cv<T>::type;
+            using difference_type = std::ptrdiff_t;
+            using size_type = std::size_t;
+            using reference = T&;
+            using pointer = T*;
+
+        private:
+            template <typename U, std::size_t>
+            friend class chunked_iterator;
+
+            value_type* const* m_dir = nullptr; ///< chunk directory
+            difference_type m_idx = 0;          ///< element index
+
+            pointer address(difference_type idx) const noexcept
+            {
+                const size_type i = idx;
+                return m_dir[i / CHUNK] + i % CHUNK;
+            }
+
+        public:
+            chunked_iterator() = default;
+            chunked_iterator(value_type* const* dir,
+                             difference_type idx) noexcept
+                    : m_dir(dir), m_idx(idx)
+            {}
+            /// convert iterator to iterator over const
+            template <typename U, typename = typename std::enable_if<
+                                          std::is_same<const U, T>::value &&
+                                          !std::is_same<U, T>::value>::type>
+            chunked_iterator(const chunked_iterator<U, CHUNK>& other) noexcept
+                    : m_dir(other.m_dir), m_idx(other.m_idx)
+            {}
+
+            reference operator*() const noexcept { return *address(m_idx); }
+            pointer operator->() const noexcept { return address(m_idx); }
+            reference operator[](difference_type n) const noexcept
+            { return *address(m_idx + n); }
+            /// number of elements contiguous in memory from here on
+            size_type contiguous_run() const noexcept
+            { return CHUNK - size_type(m_idx) % CHUNK; }
+
+            chunked_iterator& operator++() noexcept
+            { ++m_idx; return *this; }
+            chunked_iterator& operator--() noexcept
+            { --m_idx; return *this; }
+            chunked_iterator operator++(int) noexcept
+            { chunked_iterator retVal(*this); ++m_idx; return retVal; }
+            chunked_iterator operator--(int) noexcept
+            { chunked_iterator retVal(*this); --m_idx; return retVal; }
+            chunked_iterator& operator+=(difference_type n) noexcept
+            { m_idx += n; return *this; }
+            chunked_iterator& operator-=(difference_type n) noexcept
+            { m_idx -= n; return *this; }
+            chunked_iterator operator+(difference_type n) const noexcept
+            { return chunked_iterator(m_dir, m_idx + n); }
+            chunked_iterator operator-(difference_type n) const noexcept
+            { return chunked_iterator(m_dir, m_idx - n); }
+            friend chunked_iterator operator+(
+                    difference_type n, const chunked_iterator& it) noexcept
+            { return it + n; }
+            difference_type operator-(const chunked_iterator& other) const
+                    noexcept
+            { return m_idx - other.m_idx; }
+
+            bool operator==(const chunked_iterator& other) const noexcept
+            { return m_idx == other.m_idx && m_dir == other.m_dir; }
+            bool operator!=(const chunked_iterator& other) const noexcept
+            { return !(*this == other); }
+            bool operator<(const chunked_iterator& other) const noexcept
+            { return m_idx < other.m_idx; }
+            bool operator>(const chunked_iterator& other) const noexcept
+            { return other < *this; }
+            bool operator<=(const chunked_iterator& other) const noexcept
+            { return !(other < *this); }
+            bool operator>=(const chunked_iterator& other) const noexcept
+            { return !(*this < other); }
+        };
+
+        /** @brief a column stored in fixed-size chunks of CHUNK elements
+         *
+         * The column looks like a std::vector of T to SOA::Container, but
+         * keeps its elements in separately allocated, cache line aligned
+         * chunks, which are listed in a chunk directory. Growing the column
+         * adds chunks; existing elements are never moved or copied, so
+         * pointers and references to them stay valid (iterators refer to
+         * the directory, and are invalidated by growth, as for std::vector).
+         */
+        template <typename T, std::size_t CHUNK>
+        class chunked_column {
+        public:
+            using value_type = T;
+            using size_type = std::size_t;
+            using difference_type = std::ptrdiff_t;
+            using reference = T&;
+            using const_reference = const T&;
+            using pointer = T*;
+            using const_pointer = const T*;
+            using iterator = chunked_iterator<T, CHUNK>;
+            using const_iterator = chunked_iterator<const T, CHUNK>;
+            using reverse_iterator = std::reverse_iterator<iterator>;
+            using const_reverse_iterator =
+                    std::reverse_iterator<const_iterator>;
+            /// tells SOA::Container not to over-allocate on growth
+            using grows_in_place = std::true_type;
+            enum : size_type {
+                chunk_size = CHUNK, ///< number of elements in a chunk
+                alignment = 64      ///< alignment of each chunk
+            };
+
+        private:
+            static_assert(std::is_trivial<T>::value,
+                          "SOA::Chunked requires trivial field types");
+            static_assert(CHUNK && !(CHUNK & (CHUNK - 1)),
+                          "CHUNK must be a power of two");
+            using allocator_type = SOA::AlignedAllocator<T, alignment>;
+
+            std::vector<T*> m_chunks; ///< chunk directory
+            size_type m_size = 0;     ///< number of elements
+
+            /// value-initialise a temporary
+            static T make() noexcept { return T(); }
+            /// construct a temporary from arguments
+            template <typename A, typename... ARGS>
+            static T make(A&& a, ARGS&&... args)
+            {
+                T val(std::forward<A>(a), std::forward<ARGS>(args)...);
+                return val;
+            }
+
+            /// add chunks until n elements fit
+            void grow(size_type n)
+            {
+                if (n > max_size()) throw std::length_error("too large");
+                const size_type nchunks = (n + CHUNK - 1) / CHUNK;
+                // the directory is small, let it grow geometrically
+                if (nchunks > m_chunks.capacity())
+                    m_chunks.reserve(
+                            std::max(nchunks, 2 * m_chunks.capacity()));
+                while (m_chunks.size() < nchunks)
+                    m_chunks.push_back(allocator_type().allocate(CHUNK));
+            }
+            /// free chunks beyond the first nchunks
+            void release(size_type nchunks) noexcept
+            {
+                for (size_type c = nchunks; c < m_chunks.size(); ++c)
+                    allocator_type().deallocate(m_chunks[c], CHUNK);
+                m_chunks.resize(std::min(nchunks, m_chunks.size()));
+            }
+            /// open a gap of cnt elements at idx, return start of gap
+            iterator open_gap(size_type idx, size_type cnt)
+            {
+                assert(idx <= m_size);
+                grow(m_size + cnt);
+                m_size += cnt;
+                if (idx + cnt != m_size)
+                    std::copy_backward(begin() + idx, end() - cnt, end());
+                return begin() + idx;
+            }
+
+        public:
+            chunked_column() = default;
+            chunked_column(const chunked_column& other)
+                    : m_size(other.m_size)
+            {
+                try {
+                    grow(m_size);
+                } catch (...) {
+                    release(0);
+                    throw;
+                }
+                // copy chunk by chunk
+                for (size_type c = 0; c * CHUNK < m_size; ++c) {
+                    std::memcpy(m_chunks[c], other.m_chunks[c],
+                                std::min(size_type(CHUNK),
+                                         m_size - c * CHUNK) *
+                                        sizeof(T));
+                }
+            }
+            chunked_column(chunked_column&& other) noexcept
+                    : m_chunks(std::move(other.m_chunks)),
+                      m_size(other.m_size)
+            {
+                other.m_chunks.clear();
+                other.m_size = 0;
+            }
+            ~chunked_column() { release(0); }
+
+            chunked_column& operator=(const chunked_column& other)
+            {
+                if (this != &other) {
+                    chunked_column tmp(other);
+                    swap(tmp);
+                }
+                return *this;
+            }
+            chunked_column& operator=(chunked_column&& other) noexcept
+            {
+                if (this != &other) {
+                    chunked_column tmp(std::move(other));
+                    swap(tmp);
+                }
+                return *this;
+            }
+            /// exchange contents with other
+            void swap(chunked_column& other) noexcept
+            {
+                m_chunks.swap(other.m_chunks);
+                std::swap(m_size, other.m_size);
+            }
+
+            iterator begin() noexcept { return iterator(m_chunks.data(), 0); }
+            const_iterator begin() const noexcept
+            { return const_iterator(m_chunks.data(), 0); }
+            const_iterator cbegin() const noexcept { return begin(); }
+            iterator end() noexcept
+            { return iterator(m_chunks.data(), m_size); }
+            const_iterator end() const noexcept
+            { return const_iterator(m_chunks.data(), m_size); }
+            const_iterator cend() const noexcept { return end(); }
+            reverse_iterator rbegin() noexcept
+            { return reverse_iterator(end()); }
+            const_reverse_iterator rbegin() const noexcept
+            { return const_reverse_iterator(end()); }
+            const_reverse_iterator crbegin() const noexcept
+            { return const_reverse_iterator(end()); }
+            reverse_iterator rend() noexcept
+            { return reverse_iterator(begin()); }
+            const_reverse_iterator rend() const noexcept
+            { return const_reverse_iterator(begin()); }
+            const_reverse_iterator crend() const noexcept
+            { return const_reverse_iterator(begin()); }
+
+            size_type size() const noexcept { return m_size; }
+            bool empty() const noexcept { return !m_size; }
+            size_type capacity() const noexcept
+            { return m_chunks.size() * CHUNK; }
+            size_type max_size() const noexcept
+            {
+                return std::numeric_limits<difference_type>::max() /
+                       sizeof(T);
+            }
+            /// number of chunks in use
+            size_type nchunks() const noexcept
+            { return (m_size + CHUNK - 1) / CHUNK; }
+            /// start of chunk c (CHUNK contiguous, aligned elements)
+            T* chunk(size_type c) noexcept { return m_chunks[c]; }
+            const T* chunk(size_type c) const noexcept { return m_chunks[c]; }
+
+            reference operator[](size_type idx) noexcept
+            { return m_chunks[idx / CHUNK][idx % CHUNK]; }
+            const_reference operator[](size_type idx) const noexcept
+            { return m_chunks[idx / CHUNK][idx % CHUNK]; }
+            reference at(size_type idx)
+            {
+                if (idx >= m_size)
+                    throw std::out_of_range("out of bounds");
+                return (*this)[idx];
+            }
+            const_reference at(size_type idx) const
+            {
+                if (idx >= m_size)
+                    throw std::out_of_range("out of bounds");
+                return (*this)[idx];
+            }
+            reference front() noexcept { return (*this)[0]; }
+            const_reference front() const noexcept { return (*this)[0]; }
+            reference back() noexcept { return (*this)[m_size - 1]; }
+            const_reference back() const noexcept
+            { return (*this)[m_size - 1]; }
+
+            /// make room for n elements (adding chunks as needed)
+            void reserve(size_type n) { grow(n); }
+            /// free the chunks beyond the last one in use
+            void shrink_to_fit()
+            {
+                release(nchunks());
+                m_chunks.shrink_to_fit();
+            }
+            void clear() noexcept { m_size = 0; }
+            void pop_back() noexcept
+            {
+                assert(m_size);
+                --m_size;
+            }
+
+            template <typename... ARGS>
+            reference emplace_back(ARGS&&... args)
+            {
+                // construct first, args may refer to an element of ours
+                const T val(make(std::forward<ARGS>(args)...));
+                if (m_size == capacity()) grow(m_size + 1);
+                T* p = &(*this)[m_size++];
+                ::new (static_cast<void*>(p)) T(val);
+                return *p;
+            }
+            void push_back(const T& val) { emplace_back(val); }
+            void push_back(T&& val) { emplace_back(std::move(val)); }
+
+            iterator insert(const_iterator pos, size_type cnt, const T& val)
+            {
+                const T tmp(val);
+                const iterator p = open_gap(pos - cbegin(), cnt);
+                std::fill(p, p + cnt, tmp);
+                return p;
+            }
+            iterator insert(const_iterator pos, const T& val)
+            { return insert(pos, 1, val); }
+            iterator insert(const_iterator pos, T&& val)
+            { return insert(pos, 1, val); }
+            /// insert range [first, last) (must not point into this column)
+            template <typename IT,
+                      typename = typename std::enable_if<
+                              !std::is_integral<IT>::value>::type>
+            iterator insert(const_iterator pos, IT first, IT last)
+            {
+                const iterator p =
+                        open_gap(pos - cbegin(), std::distance(first, last));
+                std::copy(first, last, p);
+                return p;
+            }
+            template <typename... ARGS>
+            iterator emplace(const_iterator pos, ARGS&&... args)
+            { return insert(pos, 1, make(std::forward<ARGS>(args)...)); }
+
+            iterator erase(const_iterator first, const_iterator last) noexcept
+            {
+                const iterator p = begin() + (first - cbegin());
+                const size_type cnt = last - first;
+                if (cnt) {
+                    std::copy(p + cnt, end(), p);
+                    m_size -= cnt;
+                }
+                return p;
+            }
+            iterator erase(const_iterator pos) noexcept
+            { return erase(pos, pos + 1); }
+
+            void resize(size_type sz, const T& val)
+            {
+                if (sz > m_size) {
+                    const T tmp(val);
+                    grow(sz);
+                    std::fill(end(), begin() + sz, tmp);
+                }
+                m_size = sz;
+            }
+            void resize(size_type sz) { resize(sz, T()); }
+            /// resize, leaving new elements uninitialised
+            void resize_default_init(size_type sz)
+            {
+                grow(sz);
+                m_size = sz;
+            }
+            void assign(size_type cnt, const T& val)
+            {
+                const T tmp(val);
+                m_size = 0;
+                resize(cnt, tmp);
+            }
+        };
+
+        /// swap two chunked_columns
+        template <typename T, std::size_t CHUNK>
+        void swap(chunked_column<T, CHUNK>& a,
+                  chunked_column<T, CHUNK>& b) noexcept
+        { a.swap(b); }
+    } // namespace impl
+
+    /** @brief storage policy: keep each column in fixed-size chunks
+     *
+     * @tparam CHUNK        number of elements per chunk (a power of two)
+     *
+     * Use the nested storage template as the first template argument of
+     * SOA::Container:
+     *
+     * @code
+     * SOA::Container<SOA::Chunked<4096>::storage, SOAPointSkin> points;
+     * for (...) points.emplace_back(x, y, z); // never copies old elements
+     * @endcode
+     *
+     * Each column keeps its elements in cache line aligned chunks of CHUNK
+     * elements, listed in a per-column chunk directory. When a column runs
+     * out of room, a chunk is added; unlike std::vector, nothing is
+     * reallocated or copied, and appending never allocates more than one
+     * chunk per column beyond what is needed. Element addresses stay valid
+     * as the container grows.
+     *
+     * SOA::for_each and SOA::transform run their loops chunk by chunk over
+     * plain pointers, so they vectorise as for std::vector storage. Fields
+     * must be trivial types.
+     */
+    template <std::size_t CHUNK = 4096>
+    struct Chunked {
+        static_assert(CHUNK && !(CHUNK & (CHUNK - 1)),
+                      "CHUNK must be a power of two");
+        template <typename T>
+        using storage = impl::chunked_column<T, CHUNK>;
+    };
+} // namespace SOA
+
+#endif // SOACHUNKEDSTORAGE_H
+
+/* Copyright (C) CERN for the benefit of the LHCb collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In applying this licence, CERN does not waive the privileges and immunities
+ * granted to it by virtue of its status as an Intergovernmental Organization
+ * or submit itself to any jurisdiction.
+ */
+
+// vim: sw=4:tw=78:ft=cpp:et
@@ -60,12 +60,30 @@ namespace SOA {
                         noexcept(obj.max_size()))
                 { return obj.max_size(); }
         };
-        /// little helper for push_back
+        /** @brief little helper for push_back
+         *
+         * _Container makes room in all columns before appending, so columns
+         * which manage their capacity together (e.g. SOA::SlabStorage) can
+         * skip their own capacity check.
+         */
         struct push_backHelper {
+            /// column can append without checking capacity
             template <typename T, typename V>
-            void operator()(T&& t, V&& v) const noexcept(
+            static auto append(T& t, V&& v, int) noexcept(
+                    noexcept(t.emplace_back_unchecked(std::forward<V>(v))))
+                    -> decltype(t.reserve(1),
+                                void(t.emplace_back_unchecked(
+                                        std::forward<V>(v))))
+            { t.emplace_back_unchecked(std::forward<V>(v)); }
+            /// any other column
+            template <typename T, typename V>
+            static void append(T& t, V&& v, long) noexcept(
                     noexcept(t.push_back(std::forward<V>(v))))
             { t.push_back(std::forward<V>(v)); }
+            template <typename T, typename V>
+            void operator()(T&& t, V&& v) const noexcept(
+                    noexcept(append(t, std::forward<V>(v), 0)))
+            { append(t, std::forward<V>(v), 0); }
         };
         /// little helper for insert(it, val)
         template <typename size_type>
@@ -99,12 +117,25 @@ namespace SOA {
                     noexcept(std::forward<T>(t).resize(m_sz, std::forward<V>(val))))
             { std::forward<T>(t).resize(m_sz, std::forward<V>(val)); }
         };
-        /// little helper for emplace_back(args...)
+        /// little helper for emplace_back(args...) (see push_backHelper)
         struct emplace_backHelper {
+            /// column can append without checking capacity
+            template <typename T, typename V>
+            static auto append(T& t, V&& v, int) noexcept(
+                    noexcept(t.emplace_back_unchecked(std::forward<V>(v))))
+                    -> decltype(t.reserve(1),
+                                void(t.emplace_back_unchecked(
+                                        std::forward<V>(v))))
+            { t.emplace_back_unchecked(std::forward<V>(v)); }
+            /// any other column
+            template <typename T, typename V>
+            static void append(T& t, V&& v, long) noexcept(
+                    noexcept(t.emplace_back(std::forward<V>(v))))
+            { t.emplace_back(std::forward<V>(v)); }
             template <typename T, typename V>
             void operator()(T&& t, V&& v) const noexcept(
-                    noexcept(std::forward<T>(t).emplace_back(std::forward<V>(v))))
-            { std::forward<T>(t).emplace_back(std::forward<V>(v)); }
+                    noexcept(append(t, std::forward<V>(v), 0)))
+            { append(t, std::forward<V>(v), 0); }
         };
         /// little helper for emplace(pos, args...)
         template <typename size_type>
@@ -135,6 +166,81 @@ namespace SOA {
                         obj.begin() + m_idx + m_len)))
             { obj.erase(obj.begin() + m_idx, obj.begin() + m_idx + m_len); }
         };
+        /// pass the growth factor on to storages which grow by themselves
+        template <typename S>
+        auto set_storage_growth(S& s, double factor, int) noexcept(
+                noexcept(s.set_growth_factor(factor)))
+                -> decltype(s.set_growth_factor(factor))
+        { s.set_growth_factor(factor); }
+        /// other storages grow column by column (via grow_for)
+        template <typename S>
+        void set_storage_growth(S&, double, long) noexcept {}
+        /// little helper for resize_default_init(sz)
+        template <typename size_type>
+        struct resize_default_initHelper {
+            size_type m_sz;
+            /// columns which know how to do this themselves
+            template <typename T>
+            static auto resize(T& t, size_type sz, int) noexcept(
+                    noexcept(t.resize_default_init(sz)))
+                    -> decltype(t.resize_default_init(sz))
+            { t.resize_default_init(sz); }
+            /// reserve room if the column supports it
+            template <typename T>
+            static auto reserve(T& t, size_type sz, int)
+                    -> decltype(t.reserve(sz))
+            { t.reserve(sz); }
+            template <typename T>
+            static void reserve(T&, size_type, long) noexcept {}
+            /** @brief any other column: append using SOA::default_init
+             *
+             * The column's allocator must know how to construct from
+             * SOA::default_init (e.g. SOA::AlignedAllocator), so that this
+             * appends without writing to the new elements.
+             */
+            template <typename T>
+            static void resize(T& t, size_type sz, long)
+            {
+                static_assert(SOA::allocator_default_inits<
+                                      typename T::allocator_type>::value,
+                              "resize_default_init: column allocator must "
+                              "construct from SOA::default_init (use "
+                              "SOA::AlignedAllocator)");
+                if (sz <= t.size()) {
+                    t.erase(t.begin() + sz, t.end());
+                } else {
+                    reserve(t, sz, 0);
+                    for (size_type i = t.size(); i < sz; ++i)
+                        t.emplace_back(SOA::default_init);
+                }
+            }
+            template <typename T>
+            void operator()(T& t) const noexcept(
+                    noexcept(resize(t, 0, 0)))
+            { resize(t, m_sz, 0); }
+        };
+        /// allocator of column T constructs from SOA::default_init
+        template <typename T, typename = void>
+        struct column_allocator_default_inits : std::false_type {};
+        /// allocator of column T constructs from SOA::default_init
+        template <typename T>
+        struct column_allocator_default_inits<
+                T, std::void_t<typename T::allocator_type> >
+                : SOA::allocator_default_inits<typename T::allocator_type> {};
+        /// can column T grow without initialising its new elements?
+        template <typename T, typename = void>
+        struct column_default_inits : column_allocator_default_inits<T> {};
+        /// columns which know how to do this themselves
+        template <typename T>
+        struct column_default_inits<T, std::void_t<decltype(
+                std::declval<T&>().resize_default_init(0))> >
+                : std::true_type {};
+        /// little helper for append(view) and append_columns(ptrs..., n)
+        struct appendHelper {
+            template <typename T, typename IT>
+            void operator()(T& t, const std::pair<IT, IT>& r) const
+            { t.insert(t.end(), r.first, r.second); }
+        };
         /// little helper for assign(count, val)
         template <typename size_type>
         struct assignHelper {
@@ -152,7 +258,7 @@ namespace SOA {
         template <typename> class SKIN, typename... FIELDS>
     class _Container : public SOA::View<
                 typename SOA::Typelist::to_tuple<SOA::Typelist::typelist<FIELDS...>
-                         >::template container_tuple<CONTAINER>,
+                         >::template container_storage<CONTAINER>,
                 SKIN, FIELDS...>
     {
         private:
@@ -194,7 +300,7 @@ namespace SOA {
             /// give a short and convenient name to base class
             using BASE = SOA::View<
                 typename SOA::Typelist::to_tuple<SOA::Typelist::typelist<FIELDS...>
-                         >::template container_tuple<CONTAINER>,
+                         >::template container_storage<CONTAINER>,
                 SKIN, FIELDS...>;
 
             /// disable capacity for underlying containers that don't have it
@@ -211,6 +317,78 @@ namespace SOA {
             template <typename T>
             struct has_reserve<T, std::void_t<decltype(
                     std::declval<T>().reserve(1))> > : std::true_type {};
+            /// columns grow by reallocating, unless they say otherwise
+            template <typename T, typename = void>
+            struct grows_in_place : std::false_type {};
+            /// columns which can grow without moving their elements
+            template <typename T>
+            struct grows_in_place<T, std::void_t<typename std::decay<
+                    T>::type::grows_in_place> > : std::true_type {};
+
+            /// type of the first column
+            using first_column_type =
+                    decltype(std::get<0>(std::declval<
+                            typename BASE::SOAStorage>()));
+            /** @brief can all columns be grown at once before appending?
+             *
+             * Columns which grow in place (e.g. SOA::Chunked) need no
+             * geometric over-allocation, so they are left to grow on their
+             * own.
+             */
+            using can_grow = std::integral_constant<bool,
+                  has_reserve<first_column_type>::value &&
+                  has_capacity<first_column_type>::value &&
+                  !grows_in_place<first_column_type>::value>;
+
+            /// lower bound on the capacity of all columns
+            std::size_t m_capacity = 0;
+            /// geometric factor by which appends grow the container
+            double m_growth = 2.;
+
+            /// capacity of the columns (if they have one)
+            std::size_t storage_capacity(std::true_type) const
+            { return capacity(); }
+            /// capacity of the columns (if they have one)
+            std::size_t storage_capacity(std::false_type) const noexcept
+            { return 0; }
+            /// make room for n elements in all columns in a single step
+            void grow_for(std::size_t n, std::true_type)
+            {
+                if (n <= m_capacity) return;
+                reserve(std::max(n, std::size_t(m_capacity * m_growth)));
+                m_capacity = capacity();
+            }
+            /// columns without reserve grow on their own
+            void grow_for(std::size_t, std::false_type) noexcept {}
+            /** @brief append row (zipped with the columns) at the back
+             *
+             * If the columns have to grow, row may refer to one of our own
+             * elements, so it is copied into a COPY first, before the
+             * columns reallocate.
+             */
+            template <typename COPY, typename HELPER, typename ROW>
+            void append_row(const HELPER& helper, ROW&& row, std::true_type)
+            {
+                if (this->size() < m_capacity) {
+                    SOA::Utils::apply_zip(helper, this->m_storage,
+                                          std::forward<ROW>(row));
+                    return;
+                }
+                COPY tmp(std::forward<ROW>(row));
+                grow_for(this->size() + 1, std::true_type());
+                SOA::Utils::apply_zip(helper, this->m_storage,
+                                      std::move(tmp));
+            }
+            /// append row at the back (columns grow on their own)
+            template <typename COPY, typename HELPER, typename ROW>
+            void append_row(const HELPER& helper, ROW&& row, std::false_type)
+            {
+                SOA::Utils::apply_zip(helper, this->m_storage,
+                                      std::forward<ROW>(row));
+            }
+            /// refresh m_capacity after the columns may have reallocated
+            void sync_capacity() noexcept
+            { m_capacity = storage_capacity(can_grow()); }
 
         public:
             /// type for sizes
@@ -268,15 +446,66 @@ namespace SOA {
             /// default constructor
             _Container() = default;
             /// copy constructor
-            _Container(const self_type& other) = default;
+            _Container(const self_type& other) :
+                BASE(static_cast<const BASE&>(other)),
+                m_capacity(storage_capacity(can_grow())),
+                m_growth(other.m_growth)
+            {}
             /// move constructor
-            _Container(self_type&& other) = default;
+            _Container(self_type&& other) noexcept(
+                    std::is_nothrow_move_constructible<BASE>::value) :
+                BASE(static_cast<BASE&&>(other)), m_capacity(other.m_capacity),
+                m_growth(other.m_growth)
+            { other.m_capacity = 0; }
             /// destructor
             ~_Container() = default;
             /// assignment from other _Container
-            self_type& operator=(const self_type& other) = default;
+            self_type& operator=(const self_type& other)
+            {
+                BASE::operator=(other);
+                m_capacity = storage_capacity(can_grow());
+                m_growth = other.m_growth;
+                return *this;
+            }
             /// move-assignment from other _Container
-            self_type& operator=(self_type&& other) = default;
+            self_type& operator=(self_type&& other)
+            {
+                BASE::operator=(std::move(other));
+                m_capacity = storage_capacity(can_grow());
+                other.m_capacity = other.storage_capacity(can_grow());
+                m_growth = other.m_growth;
+                return *this;
+            }
+
+            /// swap contents of two containers
+            void swap(self_type& other) noexcept(noexcept(
+                        std::declval<BASE&>().swap(std::declval<BASE&>())))
+            {
+                BASE::swap(other);
+                std::swap(m_capacity, other.m_capacity);
+                std::swap(m_growth, other.m_growth);
+            }
+
+            /// factor by which the container grows when appending
+            double growth_factor() const noexcept { return m_growth; }
+            /** @brief set factor by which the container grows when appending
+             *
+             * When push_back or emplace_back run out of space, all columns
+             * are grown at once to growth_factor times the old capacity.
+             * Storages which manage their columns as a whole (e.g.
+             * SOA::SlabStorage) use the same factor when they grow.
+             */
+            void set_growth_factor(double factor)
+            {
+                if (!(factor > 1.)) {
+                    std::ostringstream str;
+                    str << "In " << __func__ << " (" << __FILE__ << ", line " <<
+                        __LINE__ << "): growth factor must exceed 1.";
+                    throw std::invalid_argument(str.str());
+                }
+                m_growth = factor;
+                impl::set_storage_growth(this->m_storage, factor, 0);
+            }
 
             /// fill container with count copies of val
             _Container(size_type count, const value_type& val) : BASE()
@@ -322,6 +551,7 @@ namespace SOA {
             {
                 SOA::Utils::apply(impl::shrink_to_fitHelper(),
                         this->m_storage);
+                sync_capacity();
             }
 
             /// reserve space for at least sz elements
@@ -336,13 +566,14 @@ namespace SOA {
             {
                 SOA::Utils::map(
                         typename SOA::impl::reserveHelper<size_type>{sz}, this->m_storage);
+                if (sz > m_capacity) m_capacity = sz;
             }
 
             /// return capacity of container
             template <typename DUMMY = int, typename CONT =
                 decltype(std::get<0>(std::declval<SOAStorage>()))>
             size_type capacity(DUMMY = 0, typename std::enable_if<
-                    has_capacity<CONT>::value>::type* = nullptr)
+                    has_capacity<CONT>::value>::type* = nullptr) const
             {
                 return SOA::Utils::foldl<size_type>(
                         [] (size_type a, size_type b) noexcept
@@ -371,6 +602,7 @@ namespace SOA {
             {
                 SOA::Utils::map(
                         typename SOA::impl::resizeHelper<size_type>{sz}, this->m_storage);
+                sync_capacity();
             }
 
             /// resize the container (append val if the container grows)
@@ -380,6 +612,7 @@ namespace SOA {
             {
                 SOA::Utils::apply_zip(typename SOA::impl::resizeHelper<size_type>{sz},
                         this->m_storage, val);
+                sync_capacity();
             }
 
             /// push an element at the back of the array
@@ -391,9 +624,8 @@ namespace SOA {
                             std::declval<SOAStorage&>(),
                             std::forward<T>(val))))
             {
-                SOA::Utils::apply_zip(
-                        impl::push_backHelper(), this->m_storage,
-                        std::forward<T>(val));
+                append_row<value_type>(impl::push_backHelper(),
+                                       std::forward<T>(val), can_grow());
             }
 
             /// push element from related View or Container at back of array
@@ -422,6 +654,7 @@ namespace SOA {
                 SOA::Utils::apply_zip(
                         impl::insertHelper<size_type>{pos.idx()},
                         this->m_storage, std::forward<T>(val));
+                sync_capacity();
                 return iterator{ pos.stor(), pos.idx() };
             }
 
@@ -448,6 +681,7 @@ namespace SOA {
                 SOA::Utils::apply_zip(
                         impl::insertHelper2<size_type>{pos.idx(), count},
                         this->m_storage, val);
+                sync_capacity();
                 return iterator{ pos.stor(), pos.idx() };
             }
 
@@ -517,6 +751,7 @@ namespace SOA {
                 SOA::Utils::apply_zip(
                         SOA::impl::assignHelper<size_type>{count},
                         this->m_storage, val);
+                sync_capacity();
             }
 
             /// assign the vector from a range of elements in another container
@@ -553,8 +788,10 @@ namespace SOA {
                 static_assert(std::is_constructible<naked_value_tuple_type,
                         ARGS...>::value || std::is_constructible<value_type,
                         ARGS...>::value, "Wrong arguments to emplace_back.");
-                SOA::Utils::apply_zip(SOA::impl::emplace_backHelper{}, this->m_storage,
-                        std::forward_as_tuple(std::forward<ARGS>(args)...));
+                append_row<naked_value_tuple_type>(
+                        SOA::impl::emplace_backHelper{},
+                        std::forward_as_tuple(std::forward<ARGS>(args)...),
+                        can_grow());
                 return this->back();
             }
 
@@ -584,8 +821,11 @@ namespace SOA {
                 static_assert(
                         std::is_constructible<value_type, ARGS...>::value,
                         "Wrong arguments to emplace_back.");
-                SOA::Utils::apply_zip(SOA::impl::emplace_backHelper{}, this->m_storage,
-                        SOA::impl::permute_tagged<fields_typelist>(std::forward<ARGS>(args)...));
+                append_row<naked_value_tuple_type>(
+                        SOA::impl::emplace_backHelper{},
+                        SOA::impl::permute_tagged<fields_typelist>(
+                                std::forward<ARGS>(args)...),
+                        can_grow());
                 return this->back();
             } 
 
@@ -596,8 +836,10 @@ namespace SOA {
                             std::declval<SOAStorage&>(),
                             std::forward<naked_value_tuple_type>(val))))
             {
-                SOA::Utils::apply_zip(SOA::impl::emplace_backHelper{}, this->m_storage,
-                        std::forward<naked_value_tuple_type>(val));
+                append_row<naked_value_tuple_type>(
+                        SOA::impl::emplace_backHelper{},
+                        std::forward<naked_value_tuple_type>(val),
+                        can_grow());
                 return this->back();
             }
 
@@ -607,8 +849,8 @@ namespace SOA {
                                           std::declval<SOAStorage&>(),
                                           std::forward<value_type>(val))))
             {
-                SOA::Utils::apply_zip(SOA::impl::emplace_backHelper{}, this->m_storage,
-                        std::forward<value_type>(val));
+                append_row<value_type>(SOA::impl::emplace_backHelper{},
+                        std::forward<value_type>(val), can_grow());
                 return this->back();
             }
 
@@ -639,6 +881,160 @@ namespace SOA {
                 return this->back();
             }
 
+        private:
+            /// view of a range of elements of this container
+            template <typename SEQ>
+            struct range_view;
+            /// view of a range of elements of this container
+            template <std::size_t... IDX>
+            struct range_view<std::index_sequence<IDX...> > {
+                using type = SOA::View<std::tuple<decltype(
+                        std::declval<BASE&>().template range<IDX>(
+                                std::declval<iterator>(),
+                                std::declval<iterator>()))...>,
+                        SKIN, FIELDS...>;
+            };
+            /// view of elements first to last
+            template <std::size_t... IDX>
+            typename range_view<std::index_sequence<IDX...> >::type
+            make_range_view(iterator first, iterator last,
+                            std::index_sequence<IDX...>) noexcept
+            {
+                return typename range_view<std::index_sequence<IDX...> >::type(
+                        this->template range<IDX>(first, last)...);
+            }
+            /// index sequence for all fields
+            using field_indices =
+                    decltype(std::make_index_sequence<sizeof...(FIELDS)>());
+            /// type of column IDX
+            template <std::size_t IDX>
+            using column_type = typename std::decay<decltype(std::get<IDX>(
+                    std::declval<SOAStorage&>()))>::type;
+            /// can all columns grow without initialising new elements?
+            template <typename SEQ>
+            struct columns_default_init;
+            /// can all columns grow without initialising new elements?
+            template <std::size_t... IDX>
+            struct columns_default_init<std::index_sequence<IDX...> >
+                    : std::integral_constant<bool, SOA::Utils::ALL(
+                              impl::column_default_inits<
+                                      column_type<IDX> >::value...)> {};
+
+        public:
+            /// view type returned by resize_default_init and friends
+            using range_view_type = typename range_view<field_indices>::type;
+            /// can resize_default_init be used (trivial fields, and columns
+            /// which grow without initialising new elements)?
+            using can_resize_default_init = std::integral_constant<
+                    bool, SOA::Utils::ALL(std::is_trivial<
+                                  SOA::Typelist::unwrap_t<FIELDS> >::
+                                                  value...) &&
+                                  columns_default_init<field_indices>::value>;
+
+            /** @brief resize, leaving newly added elements uninitialised
+             *
+             * Unlike resize(sz), new elements are default-initialised, so
+             * their memory is not touched (no zeroing, no first touch by
+             * this thread); all fields must be trivial. Columns which
+             * support it natively (e.g. SOA::SlabStorage) just adjust their
+             * size; std::vector/std::deque rely on SOA::AlignedAllocator.
+             *
+             * @param sz    new size of the container
+             * @returns     writable view of the new elements (empty if the
+             *              container did not grow)
+             */
+            range_view_type resize_default_init(size_type sz)
+            {
+                static_assert(SOA::Utils::ALL(std::is_trivial<
+                                      SOA::Typelist::unwrap_t<FIELDS> >::
+                                              value...),
+                              "resize_default_init needs trivial fields");
+                const size_type oldsz = this->size();
+                grow_for(sz, can_grow());
+                SOA::Utils::map(
+                        impl::resize_default_initHelper<size_type>{sz},
+                        this->m_storage);
+                return make_range_view(
+                        this->begin() + std::min(oldsz, sz),
+                        this->begin() + sz, field_indices());
+            }
+
+            /** @brief append n uninitialised elements
+             *
+             * @param n     number of elements to append
+             * @returns     writable view of the new elements
+             *
+             * See resize_default_init for details.
+             */
+            range_view_type append_uninitialized(size_type n)
+            { return resize_default_init(this->size() + n); }
+
+        private:
+            /// column in VIEW which holds our field IDX
+            template <typename VIEW, std::size_t IDX>
+            static constexpr std::size_t source_column() noexcept
+            {
+                return SOA::Typelist::map_index<
+                        fields_typelist, typename VIEW::fields_typelist,
+                        IDX>();
+            }
+            /// implementation of append(view)
+            template <typename VIEW, std::size_t... IDX>
+            iterator append_impl(const VIEW& v, std::index_sequence<IDX...>)
+            {
+                static_assert(SOA::Utils::ALL(
+                                      source_column<VIEW, IDX>() <
+                                      VIEW::fields_typelist::size()...),
+                              "view to append lacks some of our fields");
+                const size_type oldsz = this->size();
+                grow_for(oldsz + v.size(), can_grow());
+                SOA::Utils::apply_zip(
+                        SOA::impl::appendHelper{}, this->m_storage,
+                        std::make_tuple(std::make_pair(
+                                v.template begin<
+                                        source_column<VIEW, IDX>()>(),
+                                v.template end<
+                                        source_column<VIEW, IDX>()>())...));
+                return this->begin() + oldsz;
+            }
+
+        public:
+            /** @brief append all elements of a view (or container)
+             *
+             * Unlike insert(end(), first, last), which goes through the
+             * proxy iterators one element at a time, this grows the
+             * container once and then appends column by column, so
+             * trivially copyable fields end up as one memmove per column.
+             * Fields are matched by position if the field lists are
+             * identical, and by field otherwise (v may have more fields).
+             *
+             * @param v     view to append (must not alias this container)
+             * @returns     iterator to the first appended element
+             */
+            template <typename VIEW, typename = typename std::enable_if<
+                                SOA::Utils::is_view<VIEW>::value>::type>
+            iterator append(const VIEW& v)
+            { return append_impl(v, field_indices()); }
+
+            /** @brief append n elements from plain per-field arrays
+             *
+             * @param ptrs  one pointer to n elements per field, in order
+             * @param n     number of elements to append
+             * @returns     iterator to the first appended element
+             */
+            iterator append_columns(
+                    const SOA::Typelist::unwrap_t<FIELDS>*... ptrs,
+                    size_type n)
+            {
+                const size_type oldsz = this->size();
+                grow_for(oldsz + n, can_grow());
+                SOA::Utils::apply_zip(SOA::impl::appendHelper{},
+                                      this->m_storage,
+                                      std::make_tuple(std::make_pair(
+                                              ptrs, ptrs + n)...));
+                return this->begin() + oldsz;
+            }
+
             /// construct new element at position pos (in-place) from args
             template <typename... ARGS,
                       typename = typename std::enable_if<
@@ -662,6 +1058,7 @@ namespace SOA {
                         SOA::impl::emplaceHelper<size_type>{ pos.idx() },
                         this->m_storage,
                         std::forward_as_tuple(std::forward<ARGS>(args)...));
+                sync_capacity();
                 return iterator{ pos.stor(), pos.idx() };
             }
 
@@ -697,6 +1094,7 @@ namespace SOA {
                         this->m_storage,
                         SOA::impl::permute_tagged<fields_typelist>(
                                 std::forward<ARGS>(args)...));
+                sync_capacity();
                 return iterator{ pos.stor(), pos.idx() };
             }
 
@@ -713,6 +1111,7 @@ namespace SOA {
                         SOA::impl::emplaceHelper<size_type>{ pos.idx() },
                         this->m_storage,
                         std::forward<naked_value_tuple_type>(val));
+                sync_capacity();
                 return iterator{ pos.stor(), pos.idx() };
             }
 
@@ -728,10 +1127,19 @@ namespace SOA {
                         SOA::impl::emplaceHelper<size_type>{ pos.idx() },
                         this->m_storage,
                         std::forward<value_type>(val));
+                sync_capacity();
                 return iterator{ pos.stor(), pos.idx() };
             }
     };
 
+    /// for use by std::swap
+    template <template <typename...> class CONTAINER,
+        template <typename> class SKIN, typename... FIELDS>
+    void swap(_Container<CONTAINER, SKIN, FIELDS...>& a,
+              _Container<CONTAINER, SKIN, FIELDS...>& b) noexcept(
+            noexcept(a.swap(b)))
+    { a.swap(b); }
+
     /// more _Container implementation details
     namespace _ContainerImpl {
         /// helper to allow flexibility in how fields are supplied
@@ -0,0 +1,363 @@
+/** @file SOAFilterView.h
+ *
+ * @brief views of selected elements of another view (selection vectors)
+ *
+ * For copyright and license information, see the end of the file.
+ */
+#ifndef SOAFILTERVIEW_H
+#define SOAFILTERVIEW_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "c++14_compat.h"
+#include "SOAIteratorRange.h"
+#include "SOAView.h"
+#include "SOAAlgorithms.h"
+
+namespace SOA {
+    namespace impl {
+        /** @brief iterator visiting base[idx[0]], base[idx[1]], ...
+         *
+         * @tparam IT   random access iterator into the underlying column
+         * @tparam IDX  type of indices
+         */
+        template <typename IT, typename IDX>
+        class indexed_iterator {
+        private:
+            IT m_base;                  ///< start of underlying column
+            const IDX* m_idx = nullptr; ///< current index
+
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = typename std::iterator_traits<IT>::value_type;
+            using difference_type = std::ptrdiff_t;
+            using reference = typename std::iterator_traits<IT>::reference;
+            using pointer = typename std::iterator_traits<IT>::pointer;
+
+            indexed_iterator() = default;
+            indexed_iterator(IT base, const IDX* idx) noexcept
+                    : m_base(base), m_idx(idx)
+            {}
+
+            /// start of the underlying column
+            IT base() const noexcept { return m_base; }
+            /// pointer to the current index
+            const IDX* index() const noexcept { return m_idx; }
+
+            reference operator*() const { return m_base[*m_idx]; }
+            reference operator[](difference_type n) const
+            { return m_base[m_idx[n]]; }
+
+            indexed_iterator& operator++() noexcept { ++m_idx; return *this; }
+            indexed_iterator& operator--() noexcept { --m_idx; return *this; }
+            indexed_iterator operator++(int) noexcept
+            { indexed_iterator retVal(*this); ++m_idx; return retVal; }
+            indexed_iterator operator--(int) noexcept
+            { indexed_iterator retVal(*this); --m_idx; return retVal; }
+            indexed_iterator& operator+=(difference_type n) noexcept
+            { m_idx += n; return *this; }
+            indexed_iterator& operator-=(difference_type n) noexcept
+            { m_idx -= n; return *this; }
+            friend indexed_iterator operator+(indexed_iterator it,
+                                              difference_type n) noexcept
+            { return it += n; }
+            friend indexed_iterator operator+(difference_type n,
+                                              indexed_iterator it) noexcept
+            { return it += n; }
+            friend indexed_iterator operator-(indexed_iterator it,
+                                              difference_type n) noexcept
+            { return it -= n; }
+            friend difference_type
+            operator-(const indexed_iterator& a,
+                      const indexed_iterator& b) noexcept
+            { return a.m_idx - b.m_idx; }
+
+            friend bool operator==(const indexed_iterator& a,
+                                   const indexed_iterator& b) noexcept
+            { return a.m_idx == b.m_idx; }
+            friend bool operator!=(const indexed_iterator& a,
+                                   const indexed_iterator& b) noexcept
+            { return a.m_idx != b.m_idx; }
+            friend bool operator<(const indexed_iterator& a,
+                                  const indexed_iterator& b) noexcept
+            { return a.m_idx < b.m_idx; }
+            friend bool operator>(const indexed_iterator& a,
+                                  const indexed_iterator& b) noexcept
+            { return a.m_idx > b.m_idx; }
+            friend bool operator<=(const indexed_iterator& a,
+                                   const indexed_iterator& b) noexcept
+            { return a.m_idx <= b.m_idx; }
+            friend bool operator>=(const indexed_iterator& a,
+                                   const indexed_iterator& b) noexcept
+            { return a.m_idx >= b.m_idx; }
+        };
+    } // namespace impl
+
+    /** @brief view of the selected elements of another view
+     *
+     * This is a SOA::View (so element access, iterators, get<FIELD>(),
+     * for_each and friends work as usual) whose columns refer to the
+     * selected elements of the columns of another view or container. No
+     * column data is copied; the selection (a vector of indices into the
+     * underlying view) is shared between copies of the FilteredView.
+     *
+     * Like any other view, a FilteredView is invalidated by anything that
+     * invalidates iterators into the underlying container.
+     *
+     * Use SOA::filter_view to construct FilteredViews.
+     */
+    template <typename BASE>
+    class FilteredView : public BASE {
+    public:
+        /// type to tag this as a SOA::FilteredView
+        using filtered_view_tag = void;
+        /// type of the selection vector
+        using selection_type = std::vector<std::size_t>;
+
+    private:
+        /// indices of selected elements in underlying view
+        std::shared_ptr<const selection_type> m_sel;
+
+    public:
+        /// construct from selection and ranges of the selected elements
+        template <typename... RANGES>
+        FilteredView(std::shared_ptr<const selection_type> sel,
+                     RANGES&&... ranges)
+                : BASE(std::forward<RANGES>(ranges)...),
+                  m_sel(std::move(sel))
+        {}
+
+        /// indices of the selected elements in the underlying view
+        const selection_type& selection() const noexcept { return *m_sel; }
+    };
+
+    namespace impl {
+        /// type trait: is T a FilteredView?
+        template <typename T, typename = void>
+        struct is_filtered_view : std::false_type {};
+        template <typename T>
+        struct is_filtered_view<
+                T, std::void_t<typename T::filtered_view_tag> >
+                : std::true_type {};
+
+        /// work out the FilteredView type of a view (declaration only)
+        template <typename STORAGE, template <typename> class SKIN,
+                  typename... FIELDS, typename... ITS>
+        FilteredView<SOA::View<
+                std::tuple<SOA::iterator_range<
+                        indexed_iterator<ITS, std::size_t> >...>,
+                SKIN, FIELDS...> >
+        filtered_view_type(const SOA::_View<STORAGE, SKIN, FIELDS...>*,
+                           ITS...);
+
+        /// FilteredView type of a view V
+        template <typename V,
+                  typename SEQ = decltype(std::make_index_sequence<
+                                          V::fields_typelist::size()>()),
+                  bool = is_filtered_view<
+                          typename std::remove_cv<V>::type>::value>
+        struct filtered_view_of;
+        /// FilteredView type of a view V
+        template <typename V, std::size_t... IDX>
+        struct filtered_view_of<V, std::index_sequence<IDX...>, false> {
+            using type = decltype(filtered_view_type(
+                    std::declval<V*>(),
+                    std::declval<V&>().template begin<IDX>()...));
+        };
+        /// filtering a FilteredView again gives another one of the same type
+        template <typename V, std::size_t... IDX>
+        struct filtered_view_of<V, std::index_sequence<IDX...>, true> {
+            using type = typename std::remove_cv<V>::type;
+        };
+
+        /// range of elements first to last of column starting at it
+        template <typename IT>
+        SOA::iterator_range<indexed_iterator<IT, std::size_t> >
+        indexed_range(IT it, const std::size_t* first,
+                      const std::size_t* last) noexcept
+        {
+            return SOA::iterator_range<indexed_iterator<IT, std::size_t> >(
+                    indexed_iterator<IT, std::size_t>(it, first),
+                    indexed_iterator<IT, std::size_t>(it, last));
+        }
+
+        /// filter a plain view or container
+        template <typename V, std::size_t... IDX>
+        typename filtered_view_of<V>::type
+        make_filtered(V& view, std::vector<std::size_t>&& sel,
+                      std::index_sequence<IDX...> /* unused */,
+                      std::false_type /* not filtered yet */)
+        {
+            assert(sel.empty() || *std::max_element(sel.begin(), sel.end()) <
+                                          view.size());
+            auto psel = std::make_shared<const std::vector<std::size_t> >(
+                    std::move(sel));
+            const std::size_t *first = psel->data(),
+                              *last = first + psel->size();
+            return typename filtered_view_of<V>::type(
+                    psel, indexed_range(view.template begin<IDX>(), first,
+                                        last)...);
+        }
+
+        /// filter a FilteredView: compose selections, keep underlying view
+        template <typename V, std::size_t... IDX>
+        typename filtered_view_of<V>::type
+        make_filtered(V& view, std::vector<std::size_t>&& sel,
+                      std::index_sequence<IDX...> /* unused */,
+                      std::true_type /* already filtered */)
+        {
+            const auto& oldsel = view.selection();
+            for (std::size_t& idx : sel) {
+                assert(idx < oldsel.size());
+                idx = oldsel[idx];
+            }
+            auto psel = std::make_shared<const std::vector<std::size_t> >(
+                    std::move(sel));
+            const std::size_t *first = psel->data(),
+                              *last = first + psel->size();
+            return typename filtered_view_of<V>::type(
+                    psel, indexed_range(view.template begin<IDX>().base(),
+                                        first, last)...);
+        }
+
+        /// turn a mask into a selection vector
+        template <typename MASK>
+        std::vector<std::size_t> mask_to_selection(const MASK& mask)
+        {
+            // branchless: always write, advance only for selected elements
+            std::vector<std::size_t> sel(mask.size());
+            std::size_t j = 0;
+            for (std::size_t i = 0; i < mask.size(); ++i) {
+                sel[j] = i;
+                j += bool(mask[i]);
+            }
+            sel.resize(j);
+            return sel;
+        }
+
+        /// type trait: is T something we accept as selection vector/mask?
+        template <typename T>
+        struct is_selection : std::false_type {};
+        template <typename A>
+        struct is_selection<std::vector<std::size_t, A> > : std::true_type {};
+        template <typename A>
+        struct is_selection<std::vector<bool, A> > : std::true_type {};
+    } // namespace impl
+
+    /** @brief view of the elements at the given indices of a view
+     *
+     * @param view      view (or container) to select elements from
+     * @param sel       indices of the elements to select
+     *
+     * @returns SOA::FilteredView of the selected elements
+     *
+     * The selected elements appear in the order given in sel. Filtering a
+     * FilteredView gives another FilteredView of the same type, which
+     * refers directly to the original view (the selections are composed).
+     */
+    template <typename VIEW>
+    typename SOA::impl::filtered_view_of<
+            typename std::remove_reference<VIEW>::type>::type
+    filter_view(VIEW&& view, std::vector<std::size_t> sel)
+    {
+        using V = typename std::remove_reference<VIEW>::type;
+        return SOA::impl::make_filtered(
+                view, std::move(sel),
+                std::make_index_sequence<V::fields_typelist::size()>(),
+                SOA::impl::is_filtered_view<
+                        typename std::remove_cv<V>::type>());
+    }
+
+    /** @brief view of the elements of a view for which mask is true
+     *
+     * @param view      view (or container) to select elements from
+     * @param mask      one entry per element of view, true to select
+     *
+     * @returns SOA::FilteredView of the selected elements
+     */
+    template <typename VIEW>
+    typename SOA::impl::filtered_view_of<
+            typename std::remove_reference<VIEW>::type>::type
+    filter_view(VIEW&& view, const std::vector<bool>& mask)
+    {
+        assert(mask.size() == view.size());
+        return filter_view(view, SOA::impl::mask_to_selection(mask));
+    }
+
+    /** @brief view of the elements of a view for which pred is true
+     *
+     * @param view      view (or container) to select elements from
+     * @param pred      predicate
+     *
+     * @returns SOA::FilteredView of the selected elements
+     *
+     * The predicate's arguments select the fields it needs, just like for
+     * for_each, and only those columns are read.
+     *
+     * Example:
+     * @code
+     * auto c = get_some_container();
+     * // a chain of cuts, without copying any tracks
+     * auto good = SOA::filter_view(c, [] (SOA::cref<f_chi2> chi2)
+     *         { return chi2 < 3.f; });
+     * auto fast = SOA::filter_view(good, [] (SOA::cref<f_pt> pt)
+     *         { return pt > 500.f; });
+     * for (auto track: fast) do_something(track);
+     * @endcode
+     */
+    template <typename VIEW, typename PRED,
+              typename = typename std::enable_if<!SOA::impl::is_selection<
+                      typename std::decay<PRED>::type>::value>::type>
+    typename SOA::impl::filtered_view_of<
+            typename std::remove_reference<VIEW>::type>::type
+    filter_view(VIEW&& view, PRED pred)
+    {
+        using arg_typelist =
+                typename SOA::impl_algs::callable_info<PRED>::arg_typelist;
+        static_assert(
+                decltype(SOA::impl_algs::canFindArgs(
+                        std::declval<const VIEW&>(), arg_typelist()))::value,
+                "some predicate arguments not found in view");
+        static_assert(
+                decltype(SOA::impl_algs::uniqueArgs(
+                        std::declval<const VIEW&>(), arg_typelist()))::value,
+                "unable to uniquely match all arguments "
+                "- try using tagged types as argunents");
+        std::vector<unsigned char> mask(view.size());
+        SOA::impl_algs::_predicate_mask<true>(
+                std::make_index_sequence<arg_typelist::size()>(),
+                arg_typelist(), view, pred, mask);
+        return filter_view(view, SOA::impl::mask_to_selection(mask));
+    }
+} // namespace SOA
+
+#endif // SOAFILTERVIEW_H
+
+/* Copyright (C) CERN for the benefit of the LHCb collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In applying this licence, CERN does not waive the privileges and immunities
+ * granted to it by virtue of its status as an Intergovernmental Organization
+ * or submit itself to any jurisdiction.
+ */
+
+// vim: sw=4:tw=78:ft=cpp:et
@@ -12,6 +12,7 @@
 
 #include <array>
 #include <cstddef>
+#include <deque>
 #include <initializer_list>
 #include <iterator>
 #include <stdexcept>
@@ -324,6 +325,51 @@ namespace SOA {
                 is_contiguous_iterator<
                         std::initializer_list<int>::const_iterator>::value,
                 "bug in is_contiguous_iterator");
+
+        /** @brief type trait: is T a segmented iterator
+         *
+         * Segmented iterators walk through a sequence of contiguous runs of
+         * elements (e.g. the blocks of a std::deque); contiguous_run tells
+         * how many elements are left in the current run. Iterators of
+         * custom containers can take part by providing a member function
+         * contiguous_run() (see e.g. SOAChunkedStorage.h).
+         */
+        template <typename T, typename = void>
+        struct is_segmented_iterator : std::false_type {};
+        template <typename T>
+        struct is_segmented_iterator<
+                T, std::void_t<decltype(
+                           std::declval<const T&>().contiguous_run())> >
+                : std::true_type {};
+#if defined(__GLIBCXX__)
+        template <typename T, typename R, typename P>
+        struct is_segmented_iterator<std::_Deque_iterator<T, R, P>, void>
+                : std::true_type {};
+
+        /// number of elements in memory contiguous from it on
+        template <typename T, typename R, typename P>
+        std::size_t contiguous_run(
+                const std::_Deque_iterator<T, R, P>& it) noexcept
+        { return it._M_last - it._M_cur; }
+#endif // defined(__GLIBCXX__)
+        /// number of elements in memory contiguous from it on
+        template <typename IT>
+        auto contiguous_run(const IT& it) noexcept(
+                noexcept(it.contiguous_run()))
+                -> decltype(std::size_t(it.contiguous_run()))
+        { return it.contiguous_run(); }
+        /// number of elements in memory contiguous from it on (unbounded)
+        template <typename IT>
+        constexpr typename std::enable_if<is_contiguous_iterator<IT>::value,
+                                          std::size_t>::type
+        contiguous_run(const IT& /* unused */) noexcept
+        { return std::size_t(-1); }
+
+        static_assert(!is_segmented_iterator<int*>::value,
+                      "bug in is_segmented_iterator");
+        static_assert(!is_segmented_iterator<
+                              std::vector<int>::iterator>::value,
+                      "bug in is_segmented_iterator");
     } // namespace impl
 
     /** @brief build an iterator_range given two iterators
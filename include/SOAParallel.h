@@ -0,0 +1,747 @@
+/** @file SOAParallel.h
+ *
+ * @brief multi-threaded versions of SOA::for_each and SOA::transform
+ *
+ * For copyright and license information, see the end of the file.
+ */
+#ifndef SOAPARALLEL_H
+#define SOAPARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "c++14_compat.h"
+#include "SOATypelist.h"
+#include "SOAUtils.h"
+#include "SOAAlgorithms.h"
+
+namespace SOA {
+    /** @brief execution policy: run an algorithm on several threads
+     *
+     * Use SOA::par or SOA::par_reproducible to construct one.
+     */
+    struct parallel_policy {
+        /// number of threads to use (0: std::thread::hardware_concurrency)
+        unsigned nthreads;
+        /// number of elements per chunk of work (0: choose automatically)
+        std::size_t chunk;
+        /// reductions give bit-identical results for any nthreads
+        bool reproducible;
+    };
+
+    /** @brief execution policy to run an algorithm on several threads
+     *
+     * @param nthreads      number of threads to use (0: as many as there
+     *                      are hardware threads)
+     * @param chunk         number of elements per chunk of work (0: choose
+     *                      automatically, based on the size of the
+     *                      elements)
+     *
+     * @returns parallel_policy for use with SOA::for_each/SOA::transform
+     */
+    inline parallel_policy par(unsigned nthreads = 0,
+                               std::size_t chunk = 0) noexcept
+    { return parallel_policy{nthreads, chunk, false}; }
+
+    /** @brief execution policy for reproducible parallel reductions
+     *
+     * @param nthreads      number of threads to use (0: as many as there
+     *                      are hardware threads)
+     * @param chunk         number of elements per chunk of work (0: fixed
+     *                      default which does not depend on the machine or
+     *                      the elements)
+     *
+     * @returns parallel_policy for use with SOA::transform_reduce
+     *
+     * Reductions split the view into chunks whose boundaries depend only
+     * on the size of the view and chunk, and combine the per-chunk results
+     * in a fixed tree; within each chunk, values are summed pairwise. The
+     * result is therefore bit-identical for any number of threads
+     * (including one), and pairwise summation keeps the rounding error
+     * growing only logarithmically with the size of the view.
+     */
+    inline parallel_policy par_reproducible(unsigned nthreads = 0,
+                                            std::size_t chunk = 0) noexcept
+    { return parallel_policy{nthreads, chunk, true}; }
+
+    namespace impl_algs {
+        /// automatic chunks are sized to fit into this many bytes
+        constexpr std::size_t par_chunk_bytes = 32768;
+        /// chunk sizes are a multiple of this many elements
+        constexpr std::size_t par_chunk_granularity = 64;
+        /// automatic chunk size for reproducible reductions (elements)
+        constexpr std::size_t par_reproducible_chunk = 4096;
+        /// pairwise summation sums blocks of this size directly
+        constexpr std::size_t pairwise_block = 64;
+
+        /// sum of sizes of argument types
+        constexpr std::size_t row_bytes() noexcept { return 0; }
+        template <typename HEAD, typename... TAIL>
+        constexpr std::size_t row_bytes(HEAD head, TAIL... tail) noexcept
+        { return head + row_bytes(tail...); }
+        /// sum of sizes of functor arguments
+        template <typename... ARGS>
+        constexpr std::size_t row_bytes_of(
+                SOA::Typelist::typelist<ARGS...> /* unused */) noexcept
+        { return row_bytes(sizeof(typename std::decay<ARGS>::type)...); }
+
+        /// work out the chunk size
+        inline std::size_t par_chunk_size(const parallel_policy& pol,
+                                          std::size_t rowbytes) noexcept
+        {
+            std::size_t chunk = pol.chunk;
+            if (!chunk) {
+                chunk = pol.reproducible
+                                ? par_reproducible_chunk
+                                : par_chunk_bytes /
+                                          std::max(rowbytes, std::size_t(1));
+            }
+            // round up to a multiple of the granularity, so that chunks
+            // start at a suitably aligned element
+            chunk = (chunk + par_chunk_granularity - 1) /
+                    par_chunk_granularity * par_chunk_granularity;
+            return chunk;
+        }
+
+        /// number of threads to use for ntasks tasks
+        inline std::size_t par_threads(const parallel_policy& pol,
+                                       std::size_t ntasks) noexcept
+        {
+            std::size_t nthreads = pol.nthreads;
+            if (!nthreads) nthreads = std::thread::hardware_concurrency();
+            return std::min(std::max(nthreads, std::size_t(1)), ntasks);
+        }
+
+        /** @brief barrier for a group of threads, reusable
+         *
+         * wait() blocks until all count threads of the group have called
+         * it, then releases them all, and the barrier can be used again.
+         */
+        class round_barrier {
+        private:
+            std::mutex m_mtx;
+            std::condition_variable m_cv;
+            std::size_t m_count;
+            std::size_t m_waiting = 0;
+            std::size_t m_generation = 0;
+
+            /// release waiting threads if all have arrived (lock held)
+            void release_if_complete()
+            {
+                if (m_waiting < m_count) return;
+                m_waiting = 0;
+                ++m_generation;
+                m_cv.notify_all();
+            }
+
+        public:
+            explicit round_barrier(std::size_t count) : m_count(count) {}
+
+            /// wait until all threads of the group have arrived
+            void wait()
+            {
+                std::unique_lock<std::mutex> lock(m_mtx);
+                const std::size_t gen = m_generation;
+                ++m_waiting;
+                release_if_complete();
+                while (gen == m_generation) m_cv.wait(lock);
+            }
+            /// one thread less in the group (e.g. failed to start)
+            void drop()
+            {
+                std::lock_guard<std::mutex> lock(m_mtx);
+                --m_count;
+                release_if_complete();
+            }
+        };
+
+        /** @brief run task(r, t) for t in [0, ntasks) in rounds r in
+         *         [0, nrounds) on nthreads threads
+         *
+         * The threads are started once. Within a round, threads grab the
+         * next task from a shared counter, so threads which finish early
+         * pick up the remaining work; a barrier separates the rounds, so
+         * all tasks of round r are done before any task of round r + 1
+         * starts. The calling thread works, too. The first exception
+         * thrown by task stops the remaining tasks from being started, and
+         * is rethrown at the end.
+         */
+        template <typename TASK>
+        void run_rounds(std::size_t nrounds, std::size_t ntasks,
+                        std::size_t nthreads, const TASK& task)
+        {
+            if (nthreads <= 1) {
+                for (std::size_t r = 0; r < nrounds; ++r)
+                    for (std::size_t t = 0; t < ntasks; ++t) task(r, t);
+                return;
+            }
+            // one counter per round, so no reset is needed between rounds
+            std::vector<std::atomic<std::size_t> > next(nrounds);
+            for (auto& c : next) c.store(0);
+            std::atomic<bool> failed(false);
+            std::exception_ptr err;
+            std::mutex errmtx;
+            round_barrier barrier(nthreads);
+            auto work = [&]() {
+                for (std::size_t r = 0; r < nrounds; ++r) {
+                    try {
+                        for (std::size_t t;
+                             !failed && (t = next[r]++) < ntasks;)
+                            task(r, t);
+                    } catch (...) {
+                        failed = true;
+                        std::lock_guard<std::mutex> lock(errmtx);
+                        if (!err) err = std::current_exception();
+                    }
+                    if (r + 1 < nrounds) barrier.wait();
+                }
+            };
+            std::vector<std::thread> threads;
+            threads.reserve(nthreads - 1);
+            for (std::size_t i = 1; i < nthreads; ++i) {
+                try {
+                    threads.emplace_back(work);
+                } catch (...) {
+                    // could not start a thread - finish with what we have
+                    for (; i < nthreads; ++i) barrier.drop();
+                }
+            }
+            work();
+            for (auto& t : threads) t.join();
+            if (err) std::rethrow_exception(err);
+        }
+
+        /// a task for run_tasks as a single round task for run_rounds
+        template <typename TASK>
+        struct single_round_task {
+            const TASK& task;
+            void operator()(std::size_t /* round */, std::size_t t) const
+            { task(t); }
+        };
+
+        /** @brief run task(t) for t in [0, ntasks) on nthreads threads
+         *
+         * Threads grab the next task from a shared counter, so threads
+         * which finish early pick up the remaining work. The calling thread
+         * works, too. The first exception thrown by task stops the
+         * remaining tasks from being started, and is rethrown at the end.
+         */
+        template <typename TASK>
+        void run_tasks(std::size_t ntasks, std::size_t nthreads,
+                       const TASK& task)
+        { run_rounds(1, ntasks, nthreads, single_round_task<TASK>{task}); }
+
+        /// a chunk of [0, n) as a task for run_tasks
+        template <typename BODY>
+        struct chunk_task {
+            const BODY& body;
+            std::size_t n;
+            std::size_t chunk;
+            void operator()(std::size_t c) const
+            { body(c * chunk, std::min(n, (c + 1) * chunk)); }
+        };
+
+        /** @brief run body(first, last) for chunks of [0, n) on threads
+         *
+         * Chunks are scheduled as by run_tasks. Chunk boundaries depend
+         * only on n and the chunk size, not on the number of threads.
+         */
+        template <typename BODY>
+        void run_chunked(std::size_t n, const parallel_policy& pol,
+                         std::size_t rowbytes, const BODY& body)
+        {
+            if (!n) return;
+            const std::size_t chunk = par_chunk_size(pol, rowbytes);
+            const std::size_t nchunks = (n + chunk - 1) / chunk;
+            run_tasks(nchunks, par_threads(pol, nchunks),
+                      chunk_task<BODY>{body, n, chunk});
+        }
+
+        /// for_each on a chunk of elements: general iterators
+        template <typename FUNC, typename ITS, typename SEQ, typename TL>
+        struct for_each_chunk;
+        template <typename FUNC, typename ITS, std::size_t... IDXS,
+                  typename... ARGS>
+        struct for_each_chunk<FUNC, ITS, std::index_sequence<IDXS...>,
+                              SOA::Typelist::typelist<ARGS...> > {
+            FUNC& func;
+            ITS its;
+            void operator()(std::size_t first, std::size_t last) const
+            {
+                ITS cur(its);
+                nop((std::get<IDXS>(cur) += first, 0)...);
+                for (std::size_t i = first; i < last;
+                     ++i, nop((++std::get<IDXS>(cur), 0)...)) {
+                    func(ARGS(*std::get<IDXS>(cur))...);
+                }
+            }
+        };
+
+        /// for_each on a chunk of elements: raw pointers
+        template <typename FUNC, typename PTRS, typename SEQ, typename TL>
+        struct for_each_raw_chunk;
+        template <typename FUNC, typename PTRS, std::size_t... IDXS,
+                  typename... ARGS>
+        struct for_each_raw_chunk<FUNC, PTRS, std::index_sequence<IDXS...>,
+                                  SOA::Typelist::typelist<ARGS...> > {
+            FUNC& func;
+            PTRS ptrs;
+            bool aligned;
+            void operator()(std::size_t first, std::size_t last) const
+            {
+                using tl = SOA::Typelist::typelist<ARGS...>;
+                if (aligned) {
+                    _for_each_raw(last - first, func, tl(),
+                                  assume_aligned<true>(std::get<IDXS>(ptrs) +
+                                                       first)...);
+                } else {
+                    _for_each_raw(last - first, func, tl(),
+                                  (std::get<IDXS>(ptrs) + first)...);
+                }
+            }
+        };
+
+        /// helper for parallel for_each: general iterators
+        template <typename VIEW, typename FUNC, std::size_t... IDXS,
+                  typename... ARGS>
+        void _for_each(const parallel_policy& pol,
+                       std::index_sequence<IDXS...> seq,
+                       SOA::Typelist::typelist<ARGS...> tl, VIEW& view,
+                       FUNC& func, std::false_type /* contiguous */)
+        {
+            auto its = std::make_tuple(
+                    view.template begin<arg_column<VIEW, ARGS>::value>()...);
+            run_chunked(view.size(), pol, row_bytes_of(tl),
+                        for_each_chunk<FUNC, decltype(its), decltype(seq),
+                                       decltype(tl)>{func, its});
+        }
+
+        /// helper for parallel for_each: columns contiguous in memory
+        template <typename VIEW, typename FUNC, std::size_t... IDXS,
+                  typename... ARGS>
+        void _for_each(const parallel_policy& pol,
+                       std::index_sequence<IDXS...> seq,
+                       SOA::Typelist::typelist<ARGS...> tl, VIEW& view,
+                       FUNC& func, std::true_type /* contiguous */)
+        {
+            if (view.empty()) return;
+            const auto ptrs = std::make_tuple(
+                    &*view.template begin<
+                            arg_column<VIEW, ARGS>::value>()...);
+            // chunks start at multiples of par_chunk_granularity elements,
+            // so they are aligned if the start of the columns is
+            const bool aligned = SOA::Utils::ALL(
+                    0 == reinterpret_cast<std::uintptr_t>(
+                                 std::get<IDXS>(ptrs)) %
+                                 for_each_alignment...);
+            run_chunked(view.size(), pol, row_bytes_of(tl),
+                        for_each_raw_chunk<FUNC, decltype(ptrs),
+                                           decltype(seq), decltype(tl)>{
+                                func, ptrs, aligned});
+        }
+
+        /// transform on a chunk of elements
+        template <typename FUNC, typename INS, typename OUTS, typename SEQ,
+                  typename TL, typename OUTSEQ>
+        struct transform_chunk;
+        template <typename FUNC, typename INS, typename OUTS,
+                  std::size_t... IDXS, typename... ARGS, typename OUTSEQ>
+        struct transform_chunk<FUNC, INS, OUTS,
+                               std::index_sequence<IDXS...>,
+                               SOA::Typelist::typelist<ARGS...>, OUTSEQ> {
+            FUNC& func;
+            INS ins;
+            OUTS outs;
+            void operator()(std::size_t first, std::size_t last) const
+            {
+                OUTS cur(outs);
+                for (std::size_t i = first; i < last; ++i) {
+                    store_result(OUTSEQ(), cur, i,
+                                 func(ARGS(std::get<IDXS>(ins)[i])...));
+                }
+            }
+        };
+
+        /// helper for parallel transform
+        template <typename RETVAL, typename VIEW, typename FUNC,
+                  std::size_t... IDXS, typename... ARGS,
+                  std::size_t... OUTIDXS, typename... OUTARGS>
+        RETVAL _transform_par(const parallel_policy& pol,
+                              std::index_sequence<IDXS...> seq,
+                              SOA::Typelist::typelist<ARGS...> tl,
+                              std::index_sequence<OUTIDXS...> outseq,
+                              SOA::Typelist::typelist<OUTARGS...>
+                              /* unused */,
+                              VIEW& view, FUNC& func,
+                              std::true_type /* default constructible */)
+        {
+            RETVAL retVal;
+            // presize output, so each chunk can write to its own part
+            resize_for_overwrite(retVal, view.size());
+            if (retVal.empty()) return retVal;
+            const auto ins = std::make_tuple(column_start(
+                    view.template begin<arg_column<VIEW, ARGS>::value>())...);
+            const auto outs = std::make_tuple(
+                    column_start(retVal.template begin<OUTIDXS>())...);
+            run_chunked(view.size(), pol,
+                        row_bytes(sizeof(typename std::decay<ARGS>::type)...,
+                                  sizeof(OUTARGS)...),
+                        transform_chunk<FUNC, decltype(ins), decltype(outs),
+                                        decltype(seq), decltype(tl),
+                                        decltype(outseq)>{func, ins, outs});
+            return retVal;
+        }
+        /// output fields which cannot be presized: append serially
+        template <typename RETVAL, typename VIEW, typename FUNC,
+                  typename SEQ, typename TL, typename OUTSEQ,
+                  typename OUTTL>
+        RETVAL _transform_par(const parallel_policy& /* unused */, SEQ seq,
+                              TL tl, OUTSEQ outseq, OUTTL outtl, VIEW& view,
+                              FUNC& func,
+                              std::false_type /* default constructible */)
+        {
+            RETVAL retVal;
+            _transform_append(seq, tl, outseq, outtl, retVal, view, func);
+            return retVal;
+        }
+
+        /// per-chunk result of a parallel reduction
+        template <typename T>
+        struct reduce_slot {
+            T value;
+        };
+
+        /// reduce rows [first, last) (last > first) by pairwise summation
+        template <typename T, typename INS, typename RED, typename FUNC,
+                  typename SEQ, typename TL>
+        T _transform_reduce_pairwise(SEQ seq, TL tl, const INS& ins,
+                                     std::size_t first, std::size_t last,
+                                     RED& reduce, FUNC& func)
+        {
+            if (last - first <= pairwise_block) {
+                return _transform_reduce<T>(seq, tl, ins, first, last,
+                                            reduce, func);
+            }
+            // split at a multiple of the block size
+            const std::size_t mid =
+                    first + ((last - first) / 2 + pairwise_block - 1) /
+                                    pairwise_block * pairwise_block;
+            return reduce(_transform_reduce_pairwise<T>(seq, tl, ins, first,
+                                                        mid, reduce, func),
+                          _transform_reduce_pairwise<T>(seq, tl, ins, mid,
+                                                        last, reduce, func));
+        }
+
+        /// reduce a chunk of elements
+        template <typename T, typename RED, typename FUNC, typename INS,
+                  typename SEQ, typename TL>
+        struct reduce_chunk {
+            RED& reduce;
+            FUNC& func;
+            INS ins;
+            std::vector<reduce_slot<T> >& partial;
+            std::size_t chunk;
+            bool pairwise;
+            void operator()(std::size_t first, std::size_t last) const
+            {
+                partial[first / chunk].value =
+                        pairwise ? _transform_reduce_pairwise<T>(
+                                           SEQ(), TL(), ins, first, last,
+                                           reduce, func)
+                                 : _transform_reduce<T>(SEQ(), TL(), ins,
+                                                        first, last, reduce,
+                                                        func);
+            }
+        };
+
+        /// combine partial results pairwise, in a fixed order
+        template <typename T, typename RED>
+        T pairwise_combine(std::vector<reduce_slot<T> >& partial,
+                           RED& reduce)
+        {
+            for (std::size_t n = partial.size(); n > 1; n = (n + 1) / 2) {
+                for (std::size_t i = 0; i + 1 < n; i += 2) {
+                    partial[i / 2].value =
+                            reduce(partial[i].value, partial[i + 1].value);
+                }
+                if (n & 1) partial[n / 2].value = partial[n - 1].value;
+            }
+            return partial.front().value;
+        }
+    } // namespace impl_algs
+
+    /** @brief apply a function to each element of a (SOA) View in parallel
+     *
+     * @param pol           execution policy (see SOA::par)
+     * @param view          view to apply function to
+     * @param func          function/functor to apply
+     *
+     * This works like the serial for_each, but splits the view into
+     * chunks of a few tens of kilobytes each, which are handed to a set of
+     * threads as they become idle. func is called concurrently from
+     * several threads, so it must be safe to do so (e.g. only modify the
+     * element it is called for).
+     *
+     * Example:
+     * @code
+     * SOA::for_each(SOA::par(), view, [] (SOA::ref<f_x> x) { x *= 2; });
+     * @endcode
+     */
+    template <typename VIEW, typename FUNC>
+    void for_each(const parallel_policy& pol, VIEW&& view, FUNC&& func)
+    {
+        using arg_typelist =
+                typename SOA::impl_algs::callable_info<FUNC>::arg_typelist;
+        static_assert(
+                decltype(SOA::impl_algs::canFindArgs(
+                        std::declval<const VIEW&>(), arg_typelist()))::value,
+                "some function arguments not found in view");
+        static_assert(
+                decltype(SOA::impl_algs::uniqueArgs(
+                        std::declval<const VIEW&>(), arg_typelist()))::value,
+                "unable to uniquely match all arguments "
+                "- try using tagged types as argunents");
+        SOA::impl_algs::_for_each(
+                pol, std::make_index_sequence<arg_typelist::size()>(),
+                arg_typelist(), view, func,
+                decltype(SOA::impl_algs::for_each_dispatch<VIEW>(
+                        arg_typelist()))());
+    }
+
+    /** @brief transform an (SOA) View in parallel
+     *
+     * @param pol           execution policy (see SOA::par)
+     * @param view          view to transform
+     * @param func          function/functor that calculates the
+     *                      transformation
+     * @tparam SKIN         (optional) skin to use for the returned container
+     * @tparam CONTAINER    (optional) underlying container type used for
+     *                      returned container
+     *
+     * @returns a SOA::Container with the transformed result
+     *
+     * This works like the serial transform, but the output container is
+     * sized up front, and chunks of the view are transformed by several
+     * threads, each writing its results directly into its part of the
+     * output. func must be safe to call concurrently from several threads.
+     * Output fields which cannot be default-constructed rule out sizing
+     * up front; such transforms run serially.
+     */
+    template <template <class> class SKIN = SOA::impl_algs::DefaultSkin,
+              template <class...> class CONTAINER = std::vector,
+              typename VIEW, typename FUNC>
+    auto transform(const parallel_policy& pol, VIEW&& view, FUNC&& func)
+            -> decltype(SOA::transform<SKIN, CONTAINER>(
+                    std::forward<VIEW>(view), std::forward<FUNC>(func)))
+    {
+        using retval_type = decltype(SOA::transform<SKIN, CONTAINER>(
+                std::forward<VIEW>(view), std::forward<FUNC>(func)));
+        using arg_typelist =
+                typename SOA::impl_algs::callable_info<FUNC>::arg_typelist;
+        using result_typelist = typename SOA::impl_algs::typelist_from_tuple<
+                typename SOA::impl_algs::callable_info<FUNC>::result_type>::
+                typelist;
+        static_assert(
+                decltype(SOA::impl_algs::canFindArgs(
+                        std::declval<const VIEW&>(), arg_typelist()))::value,
+                "some function arguments not found in view");
+        static_assert(
+                decltype(SOA::impl_algs::uniqueArgs(
+                        std::declval<const VIEW&>(), arg_typelist()))::value,
+                "unable to uniquely match all arguments "
+                "- try using tagged types as argunents");
+        return SOA::impl_algs::_transform_par<retval_type>(
+                pol, std::make_index_sequence<arg_typelist::size()>(),
+                arg_typelist(),
+                std::make_index_sequence<result_typelist::size()>(),
+                result_typelist(), view, func,
+                SOA::impl_algs::all_fields_default_constructible<
+                        typename retval_type::fields_typelist>());
+    }
+
+    /** @brief map each element of a (SOA) View, and reduce in parallel
+     *
+     * @param pol           execution policy (see SOA::par)
+     * @param view          view to reduce
+     * @param init          initial value of the reduction
+     * @param reduce        binary reduction operation (associative and
+     *                      commutative)
+     * @param func          function/functor mapping an element to a value
+     *                      of (or convertible to) type T
+     *
+     * @returns reduce(init, reduce(func(row 0), reduce(func(row 1), ...)))
+     *
+     * Each chunk of the view is reduced on its own, and the per-chunk
+     * results are then combined pairwise in a fixed order. Since the
+     * chunks do not depend on the number of threads, the result is the
+     * same whichever thread reduces which chunk, and for any number of
+     * threads (for a given chunk size). With SOA::par_reproducible, the
+     * default chunk size is fixed as well, and chunks are summed pairwise
+     * for better accuracy.
+     */
+    template <typename VIEW, typename T, typename RED, typename FUNC>
+    T transform_reduce(const parallel_policy& pol, VIEW&& view, T init,
+                       RED reduce, FUNC&& func)
+    {
+        using arg_typelist =
+                typename SOA::impl_algs::callable_info<FUNC>::arg_typelist;
+        static_assert(
+                decltype(SOA::impl_algs::canFindArgs(
+                        std::declval<const VIEW&>(), arg_typelist()))::value,
+                "some function arguments not found in view");
+        static_assert(
+                decltype(SOA::impl_algs::uniqueArgs(
+                        std::declval<const VIEW&>(), arg_typelist()))::value,
+                "unable to uniquely match all arguments "
+                "- try using tagged types as argunents");
+        using seq = decltype(
+                std::make_index_sequence<arg_typelist::size()>());
+        const std::size_t n = view.size();
+        if (!n) return init;
+        const std::size_t rowbytes =
+                SOA::impl_algs::row_bytes_of(arg_typelist());
+        const std::size_t chunk =
+                SOA::impl_algs::par_chunk_size(pol, rowbytes);
+        std::vector<SOA::impl_algs::reduce_slot<T> > partial(
+                (n + chunk - 1) / chunk,
+                SOA::impl_algs::reduce_slot<T>{init});
+        const auto ins = SOA::impl_algs::arg_columns(view, arg_typelist());
+        SOA::impl_algs::run_chunked(
+                n, pol, rowbytes,
+                SOA::impl_algs::reduce_chunk<T, RED, FUNC, decltype(ins),
+                                             seq, arg_typelist>{
+                        reduce, func, ins, partial, chunk,
+                        pol.reproducible});
+        return reduce(init, SOA::impl_algs::pairwise_combine(partial,
+                                                             reduce));
+    }
+
+    namespace impl_algs {
+        /// aim for this many tiles in parallel pair loops
+        constexpr std::size_t par_pair_tiles = 16;
+        /// minimum number of rows per tile in parallel pair loops
+        constexpr std::size_t par_pair_min_tile = 16;
+
+        /** @brief rows per tile for parallel for_each_unique_pair
+         *
+         * Depends only on n and the size of the rows (or on pol.chunk),
+         * never on the number of threads, so the order in which each
+         * element sees its updates is the same for any number of threads.
+         */
+        template <typename VIEW>
+        std::size_t par_pair_tile(const parallel_policy& pol,
+                                  std::size_t n) noexcept
+        {
+            if (pol.chunk) return pol.chunk;
+            return std::min(pair_tile<VIEW>(),
+                            std::max(par_pair_min_tile,
+                                     (n + par_pair_tiles - 1) /
+                                             par_pair_tiles));
+        }
+
+        /** @brief rounds of tile pairs for parallel for_each_unique_pair
+         *
+         * Rounds follow the circle method for round-robin tournaments: in
+         * each round, every tile is part of exactly one pair, so the tasks
+         * of a round never update the same rows. Slot nslots - 1 stays
+         * fixed, the others rotate; tiles beyond ntiles are dummies. In
+         * round 0, the pairs within each of the two tiles are done first.
+         */
+        template <typename KERNEL>
+        struct pair_round_task {
+            const KERNEL& kernel;
+            std::size_t n, tile, ntiles, nslots;
+            void operator()(std::size_t round, std::size_t k) const
+            {
+                const std::size_t m = nslots - 1;
+                std::size_t i = (round + k) % m, j = (round + m - k) % m;
+                if (!k) j = m;
+                if (j < i) std::swap(i, j);
+                const std::size_t ifirst = i * tile;
+                const std::size_t ilast = std::min(n, ifirst + tile);
+                const std::size_t jfirst = j * tile;
+                const std::size_t jlast = std::min(n, jfirst + tile);
+                if (!round) {
+                    kernel.triangle(ifirst, ilast);
+                    if (j < ntiles) kernel.triangle(jfirst, jlast);
+                }
+                if (j < ntiles) kernel.full(ifirst, ilast, jfirst, jlast);
+            }
+        };
+    } // namespace impl_algs
+
+    /** @brief call a function once for each unordered pair of elements,
+     *         using several threads
+     *
+     * @param pol           execution policy (see SOA::par); pol.chunk sets
+     *                      the number of rows per tile
+     * @param view          view
+     * @param func          function/functor to call as func(v[i], v[j]),
+     *                      or with the fields of v[i] and v[j] as in the
+     *                      serial for_each_unique_pair
+     *
+     * Calls func(view[i], view[j]) for all i < j < view.size(), like the
+     * serial for_each_unique_pair, and func may update both elements. The
+     * view is cut into tiles, and pairs of tiles are scheduled in rounds
+     * such that no tile appears twice in a round; the threads are started
+     * once and only synchronise between rounds. Thus no two threads ever
+     * update the same element at the same time, and no locks or
+     * per-thread copies of the output are needed. The tiles depend only
+     * on the size of the view and its rows (or pol.chunk), so each element
+     * sees its updates in the same order whatever the number of threads,
+     * and results are bit-identical for any number of threads. func is
+     * called concurrently for disjoint pairs.
+     */
+    template <typename VIEW, typename FUNC>
+    void for_each_unique_pair(const parallel_policy& pol, VIEW&& view,
+                              FUNC&& func)
+    {
+        const std::size_t n = view.size();
+        if (n < 2) return;
+        const std::size_t tile =
+                SOA::impl_algs::par_pair_tile<VIEW>(pol, n);
+        const std::size_t ntiles = (n + tile - 1) / tile;
+        const std::size_t nslots = ntiles + (ntiles & 1);
+        const auto kernel =
+                SOA::impl_algs::make_pair_kernel(view, view, func);
+        SOA::impl_algs::run_rounds(
+                nslots - 1, nslots / 2,
+                SOA::impl_algs::par_threads(pol, nslots / 2),
+                SOA::impl_algs::pair_round_task<decltype(kernel)>{
+                        kernel, n, tile, ntiles, nslots});
+    }
+} // namespace SOA
+
+#endif // SOAPARALLEL_H
+
+/* Copyright (C) CERN for the benefit of the LHCb collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In applying this licence, CERN does not waive the privileges and immunities
+ * granted to it by virtue of its status as an Intergovernmental Organization
+ * or submit itself to any jurisdiction.
+ */
+
+// vim: sw=4:tw=78:ft=cpp:et
@@ -0,0 +1,313 @@
+/** @file SOASimd.h
+ *
+ * @brief for_each_simd: apply a functor to packs of W consecutive elements
+ *
+ * For copyright and license information, see the end of the file.
+ */
+#ifndef SOASIMD_H
+#define SOASIMD_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "c++14_compat.h"
+#include "SOATypelist.h"
+#include "SOAUtils.h"
+#include "SOAAlgorithms.h"
+
+namespace SOA {
+    /// fixed width vector types for for_each_simd
+    namespace simd {
+        namespace impl {
+            /// alignment of W values of type T (natural for powers of two)
+            constexpr std::size_t vec_align(std::size_t sz, std::size_t al)
+            {
+                return (sz & (sz - 1)) ? al : (sz > 64 ? 64 : sz);
+            }
+        } // namespace impl
+
+        /** @brief W values of type T, with element-wise arithmetic
+         *
+         * All operations are plain loops over the W lanes; since W is a
+         * compile time constant, compilers turn them into SIMD
+         * instructions of the right width.
+         */
+        template <typename T, std::size_t W>
+        struct vec {
+            static_assert(W > 0, "vec needs at least one lane");
+            /// type of a lane
+            using value_type = T;
+            /// number of lanes
+            static constexpr std::size_t width = W;
+            /// the lanes
+            alignas(impl::vec_align(W * sizeof(T), alignof(T))) T v[W];
+
+            /// vec with all lanes set to x
+            static vec broadcast(const T& x) noexcept
+            {
+                vec retVal;
+                for (std::size_t i = 0; i < W; ++i) retVal.v[i] = x;
+                return retVal;
+            }
+
+            T& operator[](std::size_t i) noexcept { return v[i]; }
+            const T& operator[](std::size_t i) const noexcept
+            { return v[i]; }
+
+// element-wise arithmetic: op=, and binary op with vec and scalar
+#define SOA_SIMD_VEC_OP(OP)                                                \
+    vec& operator OP##=(const vec& b) noexcept                             \
+    {                                                                      \
+        for (std::size_t i = 0; i < W; ++i) v[i] OP## = b.v[i];            \
+        return *this;                                                      \
+    }                                                                      \
+    vec& operator OP##=(const T& x) noexcept                               \
+    {                                                                      \
+        for (std::size_t i = 0; i < W; ++i) v[i] OP## = x;                 \
+        return *this;                                                      \
+    }                                                                      \
+    friend vec operator OP(vec a, const vec& b) noexcept                   \
+    { return a OP## = b; }                                                 \
+    friend vec operator OP(vec a, const T& x) noexcept                     \
+    { return a OP## = x; }                                                 \
+    friend vec operator OP(const T& x, const vec& b) noexcept              \
+    { return broadcast(x) OP## = b; }
+            SOA_SIMD_VEC_OP(+)
+            SOA_SIMD_VEC_OP(-)
+            SOA_SIMD_VEC_OP(*)
+            SOA_SIMD_VEC_OP(/)
+#undef SOA_SIMD_VEC_OP
+
+            friend vec operator-(vec a) noexcept
+            {
+                for (std::size_t i = 0; i < W; ++i) a.v[i] = -a.v[i];
+                return a;
+            }
+        };
+
+        /// lane-wise minimum
+        template <typename T, std::size_t W>
+        vec<T, W> min(vec<T, W> a, const vec<T, W>& b) noexcept
+        {
+            for (std::size_t i = 0; i < W; ++i)
+                a.v[i] = (b.v[i] < a.v[i]) ? b.v[i] : a.v[i];
+            return a;
+        }
+        /// lane-wise maximum
+        template <typename T, std::size_t W>
+        vec<T, W> max(vec<T, W> a, const vec<T, W>& b) noexcept
+        {
+            for (std::size_t i = 0; i < W; ++i)
+                a.v[i] = (a.v[i] < b.v[i]) ? b.v[i] : a.v[i];
+            return a;
+        }
+        /// lane-wise square root
+        template <typename T, std::size_t W>
+        vec<T, W> sqrt(vec<T, W> a) noexcept
+        {
+            for (std::size_t i = 0; i < W; ++i) a.v[i] = std::sqrt(a.v[i]);
+            return a;
+        }
+        /// sum over all lanes
+        template <typename T, std::size_t W>
+        T reduce_add(const vec<T, W>& a) noexcept
+        {
+            T sum = a.v[0];
+            for (std::size_t i = 1; i < W; ++i) sum += a.v[i];
+            return sum;
+        }
+        /// sum over the first n lanes (e.g. the valid lanes of a pack)
+        template <typename T, std::size_t W>
+        T reduce_add(const vec<T, W>& a, std::size_t n) noexcept
+        {
+            T sum = T();
+            for (std::size_t i = 0; i < W; ++i)
+                sum += (i < n) ? a.v[i] : T();
+            return sum;
+        }
+    } // namespace simd
+
+    /** @brief W consecutive values of field FIELD, as seen by for_each_simd
+     *
+     * This is a SOA::simd::vec which remembers which field it belongs to,
+     * and how many of its lanes hold elements of the view (lanes()).
+     */
+    template <typename FIELD, std::size_t W>
+    struct pack : simd::vec<SOA::Typelist::unwrap_t<FIELD>, W> {
+        /// field this pack belongs to
+        using field_type = FIELD;
+        /// underlying vector type
+        using vec_type = simd::vec<SOA::Typelist::unwrap_t<FIELD>, W>;
+
+        pack() = default;
+        pack(const vec_type& other) noexcept : vec_type(other) {}
+        /// assign lane values (the number of valid lanes stays)
+        pack& operator=(const vec_type& other) noexcept
+        {
+            vec_type::operator=(other);
+            return *this;
+        }
+
+        /// number of valid lanes (W except in the last pack of a view)
+        std::size_t lanes() const noexcept { return m_lanes; }
+
+        /// load cnt <= W values from it (pad by repeating the last one)
+        template <typename IT>
+        void load(IT it, std::size_t cnt)
+        {
+            for (std::size_t i = 0; i < cnt; ++i) this->v[i] = it[i];
+            for (std::size_t i = cnt; i < W; ++i)
+                this->v[i] = this->v[cnt - 1];
+            m_lanes = cnt;
+        }
+        /// store cnt <= W values to it
+        template <typename IT>
+        void store(IT it, std::size_t cnt) const
+        {
+            for (std::size_t i = 0; i < cnt; ++i) it[i] = this->v[i];
+        }
+
+    private:
+        std::size_t m_lanes = W; ///< number of valid lanes
+    };
+
+    namespace impl_algs {
+        /// is T a pack of width W?
+        template <typename T, std::size_t W>
+        struct is_pack : std::false_type {};
+        template <typename FIELD, std::size_t W>
+        struct is_pack<SOA::pack<FIELD, W>, W> : std::true_type {};
+
+        /// are all ARGS packs of width W?
+        template <std::size_t W, typename... ARGS>
+        constexpr std::integral_constant<
+                bool, SOA::Utils::ALL(is_pack<typename std::decay<
+                                                      ARGS>::type,
+                                              W>::value...)>
+        all_packs(SOA::Typelist::typelist<ARGS...> /* unused */) noexcept;
+
+        /// store pack if the functor could write to it
+        template <typename ARG, typename PACK, typename IT>
+        typename std::enable_if<
+                std::is_lvalue_reference<ARG>::value &&
+                !std::is_const<typename std::remove_reference<
+                        ARG>::type>::value>::type
+        store_if_writable(const PACK& p, IT it, std::size_t cnt)
+        { p.store(it, cnt); }
+        /// read-only pack: nothing to do
+        template <typename ARG, typename PACK, typename IT>
+        typename std::enable_if<
+                !std::is_lvalue_reference<ARG>::value ||
+                std::is_const<typename std::remove_reference<
+                        ARG>::type>::value>::type
+        store_if_writable(const PACK& /* unused */, IT /* unused */,
+                          std::size_t /* unused */) noexcept
+        {}
+
+        /// call func with packs at offset i (cnt valid lanes)
+        template <typename FUNC, typename ITS, typename PACKS,
+                  std::size_t... IDXS, typename... ARGS>
+        void _simd_step(std::index_sequence<IDXS...> /* unused */,
+                        SOA::Typelist::typelist<ARGS...> /* unused */,
+                        FUNC& func, const ITS& its, PACKS& packs,
+                        std::size_t i, std::size_t cnt)
+        {
+            nop((std::get<IDXS>(packs).load(std::get<IDXS>(its) + i, cnt),
+                 0)...);
+            func(std::get<IDXS>(packs)...);
+            nop((store_if_writable<ARGS>(std::get<IDXS>(packs),
+                                         std::get<IDXS>(its) + i, cnt),
+                 0)...);
+        }
+
+        /// helper for for_each_simd
+        template <std::size_t W, typename VIEW, typename FUNC,
+                  std::size_t... IDXS, typename... ARGS>
+        void _for_each_simd(std::index_sequence<IDXS...> seq,
+                            SOA::Typelist::typelist<ARGS...> tl, VIEW& view,
+                            FUNC& func)
+        {
+            const auto its = std::make_tuple(
+                    view.template begin<typename std::decay<
+                            ARGS>::type::field_type>()...);
+            std::tuple<typename std::decay<ARGS>::type...> packs;
+            const std::size_t n = view.size();
+            std::size_t i = 0;
+            for (; i + W <= n; i += W)
+                _simd_step(seq, tl, func, its, packs, i, W);
+            // remainder: padded on load, masked on store
+            if (i < n) _simd_step(seq, tl, func, its, packs, i, n - i);
+        }
+    } // namespace impl_algs
+
+    /** @brief apply a function to packs of W consecutive elements of a View
+     *
+     * @tparam W            number of elements (lanes) per pack
+     * @param view          view to apply function to
+     * @param func          function/functor to apply
+     *
+     * The arguments of func must be SOA::pack<FIELD, W>, which hold W
+     * consecutive values of field FIELD. Packs taken by non-const
+     * reference are written back to the view after each call; all others
+     * are read-only. If the size of the view is not a multiple of W, the
+     * last call gets packs with fewer valid lanes (see pack::lanes()):
+     * the others repeat the last valid element (so element-wise code
+     * stays finite), and only the valid lanes are written back.
+     * Reductions across lanes must skip the padding, e.g. with
+     * SOA::simd::reduce_add(x, x.lanes()).
+     *
+     * Example:
+     * @code
+     * auto view = get_some_view();
+     * SOA::for_each_simd<8>(view, [] (SOA::pack<f_x, 8>& x,
+     *                                 const SOA::pack<f_y, 8>& y) {
+     *     x = SOA::simd::sqrt(x * x + y * y);
+     * });
+     * float sum = 0;
+     * SOA::for_each_simd<8>(view, [&sum] (const SOA::pack<f_x, 8>& x) {
+     *     sum += SOA::simd::reduce_add(x, x.lanes());
+     * });
+     * @endcode
+     */
+    template <std::size_t W, typename VIEW, typename FUNC>
+    void for_each_simd(VIEW&& view, FUNC&& func)
+    {
+        using arg_typelist =
+                typename SOA::impl_algs::callable_info<FUNC>::arg_typelist;
+        static_assert(W > 0, "need at least one lane");
+        static_assert(decltype(SOA::impl_algs::all_packs<W>(
+                              arg_typelist()))::value,
+                      "function arguments must be SOA::pack<FIELD, W>");
+        SOA::impl_algs::_for_each_simd<W>(
+                std::make_index_sequence<arg_typelist::size()>(),
+                arg_typelist(), view, func);
+    }
+} // namespace SOA
+
+#endif // SOASIMD_H
+
+/* Copyright (C) CERN for the benefit of the LHCb collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In applying this licence, CERN does not waive the privileges and immunities
+ * granted to it by virtue of its status as an Intergovernmental Organization
+ * or submit itself to any jurisdiction.
+ */
+
+// vim: sw=4:tw=78:ft=cpp:et
@@ -0,0 +1,527 @@
+/** @file SOASlabStorage.h
+ *
+ * @brief storage policy keeping all columns of a container in one slab
+ *
+ * For copyright and license information, see the end of the file.
+ */
+#ifndef SOASLABSTORAGE_H
+#define SOASLABSTORAGE_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "AlignedAllocator.h"
+#include "SOATypelist.h"
+#include "SOATypelistUtils.h"
+#include "c++14_compat.h"
+
+namespace SOA {
+    /** @brief storage policy: keep all columns in a single aligned slab
+     *
+     * Use this in place of std::vector as the first template argument of
+     * SOA::Container:
+     *
+     * @code
+     * SOA::Container<SOA::SlabStorage, SOAPointSkin> points;
+     * points.reserve(1024); // one allocation for all fields
+     * @endcode
+     *
+     * All columns live in one contiguous, cache line aligned buffer; each
+     * column starts at a cache line aligned offset inside that buffer.
+     * Columns share a single capacity, so growing the container (from
+     * reserve, or when an append runs out of space) performs a single
+     * allocation and a single copy pass for all fields, instead of one per
+     * field.
+     *
+     * Since the columns are moved around with memcpy, all fields must be
+     * trivial types.
+     *
+     * This template is never instantiated, it only serves to select the
+     * storage implementation (see SOA::impl::slab_storage).
+     */
+    template <typename... T>
+    class SlabStorage;
+
+    namespace impl {
+        template <typename... COLUMNS>
+        class slab_storage;
+        template <typename T, typename TL>
+        class slab_column;
+
+        /** @brief one column inside a slab_storage
+         *
+         * The column looks like a std::vector of T to SOA::Container, but
+         * forwards all capacity management to the slab it lives in.
+         * Columns cannot be copied or moved on their own, only together with
+         * the slab_storage that owns them.
+         */
+        template <typename T, typename... ALL>
+        class slab_column<T, SOA::Typelist::typelist<ALL...> > {
+        public:
+            using value_type = T;
+            using size_type = std::size_t;
+            using difference_type = std::ptrdiff_t;
+            using reference = T&;
+            using const_reference = const T&;
+            using pointer = T*;
+            using const_pointer = const T*;
+            using iterator = T*;
+            using const_iterator = const T*;
+            using reverse_iterator = std::reverse_iterator<iterator>;
+            using const_reverse_iterator =
+                    std::reverse_iterator<const_iterator>;
+
+        private:
+            static_assert(std::is_trivial<T>::value,
+                          "SOA::SlabStorage requires trivial field types");
+            template <typename... COLUMNS>
+            friend class slab_storage;
+            /// type of the slab this column lives in
+            using storage_type = slab_storage<
+                    slab_column<ALL, SOA::Typelist::typelist<ALL...> >...>;
+
+            T* m_data = nullptr;              ///< start of column in slab
+            size_type m_size = 0;             ///< number of elements
+            storage_type* m_parent = nullptr; ///< slab owning the column
+
+            /// value-initialise a temporary
+            static T make() noexcept { return T(); }
+            /// construct a temporary from arguments
+            template <typename A, typename... ARGS>
+            static T make(A&& a, ARGS&&... args)
+            {
+                T val(std::forward<A>(a), std::forward<ARGS>(args)...);
+                return val;
+            }
+
+            /// open a gap of cnt elements at idx, return start of gap
+            T* open_gap(size_type idx, size_type cnt)
+            {
+                assert(idx <= m_size);
+                if (m_size + cnt > capacity()) m_parent->grow(m_size + cnt);
+                T* p = m_data + idx;
+                if (idx != m_size)
+                    std::memmove(p + cnt, p, (m_size - idx) * sizeof(T));
+                m_size += cnt;
+                return p;
+            }
+
+            /// move contents to dst (which must have enough room)
+            void relocate(char* dst) noexcept
+            {
+                T* p = reinterpret_cast<T*>(dst);
+                if (m_size) std::memcpy(p, m_data, m_size * sizeof(T));
+                m_data = p;
+            }
+            /// copy contents of other (enough room must be available)
+            void copy_from(const slab_column& other) noexcept
+            {
+                m_size = other.m_size;
+                if (m_size)
+                    std::memcpy(m_data, other.m_data, m_size * sizeof(T));
+            }
+            /// exchange contents with other (capacity is the slab's job)
+            void swap_contents(slab_column& other) noexcept
+            {
+                std::swap(m_data, other.m_data);
+                std::swap(m_size, other.m_size);
+            }
+
+        public:
+            slab_column() = default;
+            slab_column(const slab_column&) = delete;
+            slab_column(slab_column&&) = delete;
+            slab_column& operator=(const slab_column&) = delete;
+            slab_column& operator=(slab_column&&) = delete;
+
+            iterator begin() noexcept { return m_data; }
+            const_iterator begin() const noexcept { return m_data; }
+            const_iterator cbegin() const noexcept { return m_data; }
+            iterator end() noexcept { return m_data + m_size; }
+            const_iterator end() const noexcept { return m_data + m_size; }
+            const_iterator cend() const noexcept { return m_data + m_size; }
+            reverse_iterator rbegin() noexcept
+            { return reverse_iterator(end()); }
+            const_reverse_iterator rbegin() const noexcept
+            { return const_reverse_iterator(end()); }
+            const_reverse_iterator crbegin() const noexcept
+            { return const_reverse_iterator(end()); }
+            reverse_iterator rend() noexcept
+            { return reverse_iterator(begin()); }
+            const_reverse_iterator rend() const noexcept
+            { return const_reverse_iterator(begin()); }
+            const_reverse_iterator crend() const noexcept
+            { return const_reverse_iterator(begin()); }
+
+            T* data() noexcept { return m_data; }
+            const T* data() const noexcept { return m_data; }
+            size_type size() const noexcept { return m_size; }
+            bool empty() const noexcept { return !m_size; }
+            size_type capacity() const noexcept
+            { return m_parent->capacity(); }
+            size_type max_size() const noexcept
+            { return m_parent->max_size(); }
+
+            reference operator[](size_type idx) noexcept
+            { return m_data[idx]; }
+            const_reference operator[](size_type idx) const noexcept
+            { return m_data[idx]; }
+            reference at(size_type idx)
+            {
+                if (idx >= m_size)
+                    throw std::out_of_range("out of bounds");
+                return m_data[idx];
+            }
+            const_reference at(size_type idx) const
+            {
+                if (idx >= m_size)
+                    throw std::out_of_range("out of bounds");
+                return m_data[idx];
+            }
+            reference front() noexcept { return m_data[0]; }
+            const_reference front() const noexcept { return m_data[0]; }
+            reference back() noexcept { return m_data[m_size - 1]; }
+            const_reference back() const noexcept
+            { return m_data[m_size - 1]; }
+
+            /// reserve room for n elements (in all columns of the slab)
+            void reserve(size_type n) { m_parent->reserve(n); }
+            /// shrink the slab to fit the contents
+            void shrink_to_fit() { m_parent->shrink_to_fit(); }
+            void clear() noexcept { m_size = 0; }
+            void pop_back() noexcept
+            {
+                assert(m_size);
+                --m_size;
+            }
+
+            template <typename... ARGS>
+            reference emplace_back(ARGS&&... args)
+            {
+                // construct first, args may refer to an element of ours
+                const T val(make(std::forward<ARGS>(args)...));
+                if (m_size == capacity()) m_parent->grow(m_size + 1);
+                T* p = m_data + m_size++;
+                ::new (static_cast<void*>(p)) T(val);
+                return *p;
+            }
+            /// append, caller guarantees that size() < capacity()
+            template <typename... ARGS>
+            reference emplace_back_unchecked(ARGS&&... args)
+            {
+                assert(m_size < capacity());
+                T* p = m_data + m_size++;
+                ::new (static_cast<void*>(p))
+                        T(make(std::forward<ARGS>(args)...));
+                return *p;
+            }
+            void push_back(const T& val) { emplace_back(val); }
+            void push_back(T&& val) { emplace_back(std::move(val)); }
+
+            iterator insert(const_iterator pos, size_type cnt, const T& val)
+            {
+                const T tmp(val);
+                T* p = open_gap(pos - cbegin(), cnt);
+                std::fill(p, p + cnt, tmp);
+                return p;
+            }
+            iterator insert(const_iterator pos, const T& val)
+            { return insert(pos, 1, val); }
+            iterator insert(const_iterator pos, T&& val)
+            { return insert(pos, 1, val); }
+            /// insert range [first, last) (must not point into this column)
+            template <typename IT,
+                      typename = typename std::enable_if<
+                              !std::is_integral<IT>::value>::type>
+            iterator insert(const_iterator pos, IT first, IT last)
+            {
+                T* p = open_gap(pos - cbegin(), std::distance(first, last));
+                std::copy(first, last, p);
+                return p;
+            }
+            template <typename... ARGS>
+            iterator emplace(const_iterator pos, ARGS&&... args)
+            { return insert(pos, 1, make(std::forward<ARGS>(args)...)); }
+
+            iterator erase(const_iterator first, const_iterator last) noexcept
+            {
+                T* p = m_data + (first - cbegin());
+                const size_type cnt = last - first;
+                if (cnt) {
+                    std::memmove(p, p + cnt,
+                                 (m_size - (p - m_data) - cnt) * sizeof(T));
+                    m_size -= cnt;
+                }
+                return p;
+            }
+            iterator erase(const_iterator pos) noexcept
+            { return erase(pos, pos + 1); }
+
+            void resize(size_type sz, const T& val)
+            {
+                if (sz > m_size) {
+                    const T tmp(val);
+                    if (sz > capacity()) m_parent->grow(sz);
+                    std::fill(m_data + m_size, m_data + sz, tmp);
+                }
+                m_size = sz;
+            }
+            void resize(size_type sz) { resize(sz, T()); }
+            /// resize, leaving new elements uninitialised
+            void resize_default_init(size_type sz)
+            {
+                if (sz > capacity()) m_parent->grow(sz);
+                m_size = sz;
+            }
+            void assign(size_type cnt, const T& val)
+            {
+                const T tmp(val);
+                m_size = 0;
+                resize(cnt, tmp);
+            }
+        };
+
+        /** @brief storage for SOA::SlabStorage backed containers
+         *
+         * This is a tuple of columns (so std::get and friends work), with
+         * the column memory managed by the tuple as a whole: all columns
+         * share one buffer, and a single capacity.
+         */
+        template <typename... COLUMNS>
+        class slab_storage : public std::tuple<COLUMNS...> {
+        public:
+            using size_type = std::size_t;
+
+        private:
+            template <typename T, typename TL>
+            friend class slab_column;
+            /// alignment of the slab and of each column inside it
+            enum : size_type { alignment = 64 };
+            using allocator_type = SOA::AlignedAllocator<char, alignment>;
+            using base_type = std::tuple<COLUMNS...>;
+            using indices =
+                    decltype(std::make_index_sequence<sizeof...(COLUMNS)>());
+
+            char* m_buf = nullptr;   ///< the slab
+            size_type m_capacity = 0; ///< capacity of all columns
+            double m_growth = 2.;     ///< geometric growth factor
+
+            base_type& base() noexcept { return *this; }
+            const base_type& base() const noexcept { return *this; }
+
+            /// round up nbytes to a multiple of the alignment
+            constexpr static size_type padded(size_type nbytes) noexcept
+            { return (nbytes + alignment - 1) & ~size_type(alignment - 1); }
+            /// size of slab in bytes for given capacity
+            static size_type slab_bytes(size_type cap) noexcept
+            {
+                size_type nbytes = 0;
+                for (size_type sz :
+                     {sizeof(typename COLUMNS::value_type)...})
+                    nbytes += padded(cap * sz);
+                return nbytes;
+            }
+            /// number of elements in the longest column
+            size_type used() const noexcept
+            { return used(indices()); }
+            template <std::size_t... IDX>
+            size_type used(std::index_sequence<IDX...>) const noexcept
+            { return std::max({ std::get<IDX>(base()).size()... }); }
+
+            /// make columns point back at this slab
+            template <std::size_t... IDX>
+            void attach(std::index_sequence<IDX...>) noexcept
+            {
+                (void) std::initializer_list<int>{
+                        (std::get<IDX>(base()).m_parent = this, 0)...};
+            }
+            /// move columns to new slab buf with capacity cap
+            template <std::size_t... IDX>
+            void relocate(char* buf, size_type cap,
+                          std::index_sequence<IDX...>) noexcept
+            {
+                // offsets are computed per column, so the order in which
+                // the columns are relocated does not matter
+                (void) std::initializer_list<int>{(
+                        std::get<IDX>(base()).relocate(
+                                buf + offset(IDX, cap)), 0)...};
+            }
+            /// offset of column idx inside a slab with capacity cap
+            static size_type offset(size_type idx, size_type cap) noexcept
+            {
+                size_type off = 0;
+                for (size_type sz :
+                     {sizeof(typename COLUMNS::value_type)...}) {
+                    if (!idx--) break;
+                    off += padded(cap * sz);
+                }
+                return off;
+            }
+            template <std::size_t... IDX>
+            void copy_from(const slab_storage& other,
+                           std::index_sequence<IDX...>) noexcept
+            {
+                (void) std::initializer_list<int>{
+                        (std::get<IDX>(base()).copy_from(
+                                 std::get<IDX>(other.base())), 0)...};
+            }
+            template <std::size_t... IDX>
+            void swap_contents(slab_storage& other,
+                               std::index_sequence<IDX...>) noexcept
+            {
+                (void) std::initializer_list<int>{
+                        (std::get<IDX>(base()).swap_contents(
+                                 std::get<IDX>(other.base())), 0)...};
+            }
+
+            /// move all columns into a new slab with capacity newcap
+            void reallocate(size_type newcap)
+            {
+                assert(newcap >= used());
+                char* buf = newcap ? allocator_type().allocate(
+                                             slab_bytes(newcap)) : nullptr;
+                relocate(buf, newcap, indices());
+                release();
+                m_buf = buf;
+                m_capacity = newcap;
+            }
+            /// grow so that at least n elements fit (geometrically)
+            void grow(size_type n)
+            { reallocate(std::max(n, size_type(m_capacity * m_growth))); }
+            /// free the slab
+            void release() noexcept
+            {
+                if (m_buf)
+                    allocator_type().deallocate(m_buf,
+                                                slab_bytes(m_capacity));
+            }
+
+        public:
+            slab_storage() : base_type() { attach(indices()); }
+            slab_storage(const slab_storage& other) :
+                base_type(), m_growth(other.m_growth)
+            {
+                attach(indices());
+                reserve(other.used());
+                copy_from(other, indices());
+            }
+            slab_storage(slab_storage&& other) noexcept : base_type()
+            {
+                attach(indices());
+                swap(other);
+            }
+            ~slab_storage() { release(); }
+
+            slab_storage& operator=(const slab_storage& other)
+            {
+                if (this != &other) {
+                    slab_storage tmp(other);
+                    swap(tmp);
+                }
+                return *this;
+            }
+            slab_storage& operator=(slab_storage&& other) noexcept
+            {
+                if (this != &other) {
+                    slab_storage tmp(std::move(other));
+                    swap(tmp);
+                }
+                return *this;
+            }
+            /// exchange contents with other
+            void swap(slab_storage& other) noexcept
+            {
+                std::swap(m_buf, other.m_buf);
+                std::swap(m_capacity, other.m_capacity);
+                std::swap(m_growth, other.m_growth);
+                swap_contents(other, indices());
+            }
+
+            /// capacity (shared by all columns)
+            size_type capacity() const noexcept { return m_capacity; }
+            /// maximum number of elements
+            size_type max_size() const noexcept
+            {
+                return std::numeric_limits<size_type>::max() /
+                       slab_bytes(1);
+            }
+            /// factor by which columns grow when they run out of space
+            void set_growth_factor(double factor) noexcept
+            { m_growth = factor; }
+            /// make room for n elements in all columns at once
+            void reserve(size_type n)
+            {
+                if (n > max_size()) throw std::length_error("too large");
+                if (n > m_capacity) reallocate(n);
+            }
+            /// free unused capacity
+            void shrink_to_fit()
+            {
+                const size_type n = used();
+                if (n < m_capacity) reallocate(n);
+            }
+        };
+
+        /// swap two slab_storages
+        template <typename... COLUMNS>
+        void swap(slab_storage<COLUMNS...>& a,
+                  slab_storage<COLUMNS...>& b) noexcept
+        { a.swap(b); }
+    } // namespace impl
+
+    namespace Typelist {
+        namespace _to_tuple_impl {
+            /// SlabStorage: all columns managed by a single slab_storage
+            template <typename... ARGS>
+            struct select_storage<SOA::SlabStorage, typelist<ARGS...> > {
+                using _t = SOA::impl::slab_storage<SOA::impl::slab_column<
+                        ARGS, typelist<ARGS...> >...>;
+            };
+        } // namespace _to_tuple_impl
+    } // namespace Typelist
+} // namespace SOA
+
+namespace std {
+    /// slab_storage behaves like a tuple of its columns
+    template <typename... COLUMNS>
+    struct tuple_size<SOA::impl::slab_storage<COLUMNS...> >
+            : std::integral_constant<std::size_t, sizeof...(COLUMNS)> {};
+    /// slab_storage behaves like a tuple of its columns
+    template <std::size_t IDX, typename... COLUMNS>
+    struct tuple_element<IDX, SOA::impl::slab_storage<COLUMNS...> >
+            : std::tuple_element<IDX, std::tuple<COLUMNS...> > {};
+} // namespace std
+
+#endif // SOASLABSTORAGE_H
+
+/* Copyright (C) CERN for the benefit of the LHCb collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In applying this licence, CERN does not waive the privileges and immunities
+ * granted to it by virtue of its status as an Intergovernmental Organization
+ * or submit itself to any jurisdiction.
+ */
+
+// vim: sw=4:tw=78:ft=cpp:et
@@ -109,6 +109,35 @@ namespace SOA {
                 using _t = std::deque<T, CacheLineAlignedAllocator<T>>;
 #endif
             };
+
+            /** @brief select the storage type given the concrete columns
+             *
+             * By default, this is a tuple of the column containers. Storage
+             * policies which manage all columns together can specialise
+             * this for their (tag) column types (see e.g. SOAAoSoAStorage.h).
+             */
+            template <typename... COLUMNS>
+            struct select_column_storage {
+                using _t = std::tuple<COLUMNS...>;
+            };
+
+            /** @brief select the storage type for a list of column types
+             *
+             * By default, this is a tuple of one concrete container per
+             * column. Storage policies which manage all columns together
+             * (see e.g. SOASlabStorage.h) specialise this for their
+             * CONTAINER template.
+             */
+            template <template <typename...> class CONTAINER, typename TL>
+            struct select_storage;
+            /// default: tuple of independent containers
+            template <template <typename...> class CONTAINER,
+                      typename... ARGS>
+            struct select_storage<CONTAINER, typelist<ARGS...> > {
+                using _t = typename select_column_storage<
+                        typename select_concrete_container<
+                                ARGS, CONTAINER>::_t...>::_t;
+            };
         }
 
         /// class to give tuple types based on TL's listed types
@@ -135,6 +164,9 @@ namespace SOA {
                 using const_reference_tuple = decltype(to_cref_tuple_fn(typename TL::template map_t<unwrap_t>::template map_t<decay_t>()));
                 template <template <typename...> class CONTAINER = std::vector>
                 using container_tuple = decltype(to_tuple_fn(typename TL::template map_t<unwrap_t>::template map_t<container_of<CONTAINER>::template _t>()));
+                /// storage type used by SOA::Container (usually container_tuple)
+                template <template <typename...> class CONTAINER = std::vector>
+                using container_storage = typename _to_tuple_impl::select_storage<CONTAINER, typename TL::template map_t<unwrap_t> >::_t;
         };
 
         /// test implementation of to_tuple
@@ -157,6 +189,25 @@ namespace SOA {
                     std::tuple<std::vector<int, CacheLineAlignedAllocator<int> >,
                         std::vector<float, CacheLineAlignedAllocator<float> > > >::value,
                     "implementation error");
+            static_assert(std::is_same<
+                    typename to_tuple<typelist<int, float> >::template container_storage<std::vector>,
+                    typename to_tuple<typelist<int, float> >::template container_tuple<std::vector> >::value,
+                    "implementation error");
+        }
+
+        /** @brief position in TO of element IDX of FROM
+         *
+         * Identical lists map one-to-one (this also copes with repeated
+         * untagged field types), otherwise the element is looked up by
+         * type; returns TO::size() or more if TO lacks it.
+         */
+        template <typename FROM, typename TO, std::size_t IDX>
+        constexpr std::size_t map_index() noexcept
+        {
+            return std::is_same<FROM, TO>::value
+                           ? IDX
+                           : TO::template find<typename FROM::template at<
+                                     IDX>::type>();
         }
     } // namespace Typelist
 } // namespace SOA
@@ -8,8 +8,14 @@
  * For copyright and license information, see the end of the file.
  */
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+
 #include "gtest/gtest.h"
 #include "SOAAlgorithms.h"
+#include "SOAAoSoAStorage.h"
 
 namespace Fields {
     SOAFIELD_TRIVIAL(f_x, x, float);
@@ -17,6 +23,12 @@ namespace Fields {
     SOAFIELD_TRIVIAL(f_n, n, int);
     SOASKIN_TRIVIAL(SkinUnique, f_x, f_n);
     SOASKIN_TRIVIAL(SkinNonUnique, f_x, f_y, f_n);
+    /// field type without default constructor
+    struct NoDefault {
+        explicit NoDefault(int v) : val(v) {}
+        int val;
+    };
+    SOAFIELD_TRIVIAL(f_nd, nd, NoDefault);
 }
 
 TEST(SOAAlgorithms, TransformUniqueFields) {
@@ -82,6 +94,202 @@ TEST(SOAAlgorithms, TransformNonUniqueFieldsMultipleReturn) {
     EXPECT_EQ(5.f, c2[3].y());
 }
 
+TEST(SOAAlgorithms, TransformDirectWrite) {
+    using namespace Fields;
+    SOA::Container<std::vector, SkinNonUnique> c1;
+    struct Func {
+        std::tuple<SOA::value<f_y>, SOA::value<f_n> >
+        operator()(SOA::cref<f_x> x, SOA::cref<f_n> n) const
+        {
+            return std::make_tuple(SOA::value<f_y>(2 * x),
+                                   SOA::value<f_n>(-n));
+        }
+    };
+    EXPECT_TRUE(transform(c1, Func()).empty());
+    for (int i = 0; i < 1000; ++i) c1.emplace_back(i, 0.f, i);
+    auto c2 = transform(c1, Func());
+    EXPECT_EQ(c1.size(), c2.size());
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(2.f * i, c2[i].y());
+        EXPECT_EQ(-i, c2[i].n());
+    }
+}
+
+TEST(SOAAlgorithms, TransformNoDefaultConstructor) {
+    using namespace Fields;
+    SOA::Container<std::vector, SkinNonUnique> c1;
+    struct Func {
+        std::tuple<SOA::value<f_nd>, SOA::value<f_y> >
+        operator()(SOA::cref<f_n> n, SOA::cref<f_x> x) const
+        {
+            return std::make_tuple(SOA::value<f_nd>(NoDefault(2 * n)),
+                                   SOA::value<f_y>(-x));
+        }
+    };
+    EXPECT_TRUE(transform(c1, Func()).empty());
+    for (int i = 0; i < 100; ++i) c1.emplace_back(i, 0.f, i);
+    // output cannot be presized: falls back to appending element-wise
+    auto c2 = transform(c1, Func());
+    ASSERT_EQ(c1.size(), c2.size());
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(2 * i, c2[i].nd().val);
+        EXPECT_EQ(-float(i), c2[i].y());
+    }
+}
+
+/// column container with the standard allocator
+template <typename T>
+using plainvec = std::vector<T>;
+
+TEST(SOAAlgorithms, StdAllocatorOutput) {
+    using namespace Fields;
+    SOA::Container<std::vector, SkinNonUnique> c;
+    for (int i = 0; i < 100; ++i) c.emplace_back(i, 0.f, -i);
+    struct Func {
+        std::tuple<SOA::value<f_y>, SOA::value<f_n> >
+        operator()(SOA::cref<f_x> x, SOA::cref<f_n> n) const
+        { return std::make_tuple(SOA::value<f_y>(2 * x),
+                                 SOA::value<f_n>(n - 1)); }
+    };
+    // columns cannot skip initialisation: output is resized as usual
+    using out_type = decltype(
+            SOA::transform<SOA::impl_algs::DefaultSkin, plainvec>(
+                    c, Func()));
+    static_assert(!out_type::can_resize_default_init::value,
+                  "std::allocator columns must be initialised");
+    const auto t =
+            SOA::transform<SOA::impl_algs::DefaultSkin, plainvec>(c, Func());
+    ASSERT_EQ(c.size(), t.size());
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(2.f * i, t[i].y());
+        EXPECT_EQ(-i - 1, t[i].n());
+    }
+    const auto g = SOA::gather<plainvec>(c, std::vector<int>{ 7, 3 });
+    ASSERT_EQ(2u, g.size());
+    EXPECT_EQ(7.f, g[0].x());
+    EXPECT_EQ(-3, g[1].n());
+}
+
+TEST(SOAAlgorithms, TransformReduce) {
+    using namespace Fields;
+    SOA::Container<std::vector, SkinNonUnique> c1;
+    struct Sum {
+        float operator()(SOA::cref<f_x> x) const { return x; }
+    };
+    EXPECT_EQ(5.f, SOA::transform_reduce(c1, 5.f, std::plus<float>(),
+                                         Sum()));
+    for (int i = 0; i < 3; ++i) c1.emplace_back(i, 2.f * i, i);
+    EXPECT_EQ(8.f, SOA::transform_reduce(c1, 5.f, std::plus<float>(),
+                                         Sum()));
+    for (int i = 3; i < 1001; ++i) c1.emplace_back(i, 2.f * i, i);
+    struct Moments {
+        std::tuple<float, float, int>
+        operator()(SOA::cref<f_x> x, SOA::cref<f_y> y, int n) const
+        { return std::make_tuple(float(x), x * y, n); }
+    };
+    const auto r = SOA::transform_reduce(
+            c1, std::make_tuple(0.f, 0.f, 0), SOA::elementwise_plus(),
+            Moments());
+    float sx = 0, sxy = 0;
+    int sn = 0;
+    for (int i = 0; i < 1001; ++i) sx += i, sxy += 2.f * i * i, sn += i;
+    EXPECT_FLOAT_EQ(sx, std::get<0>(r));
+    EXPECT_FLOAT_EQ(sxy, std::get<1>(r));
+    EXPECT_EQ(sn, std::get<2>(r));
+    struct Max {
+        int operator()(int a, int b) const { return std::max(a, b); }
+    };
+    struct N {
+        int operator()(SOA::cref<f_n> n) const { return (n * 37) % 1001; }
+    };
+    EXPECT_EQ(1000, SOA::transform_reduce(c1, -1, Max(), N()));
+}
+
+TEST(SOAAlgorithms, ForEachPair) {
+    using namespace Fields;
+    using C = SOA::Container<std::vector, SkinNonUnique>;
+    C a, b;
+    for (int i = 0; i < 700; ++i) a.emplace_back(i, 0.f, i);
+    for (int i = 0; i < 1100; ++i) b.emplace_back(i, 0.f, 1);
+    std::vector<int> cnt(a.size() * b.size(), 0);
+    SOA::for_each_pair(a, b, [&cnt](C::reference x, C::reference y) {
+        ++cnt[std::size_t(x.x()) * 1100 + std::size_t(y.x())];
+        x.y() += y.n();
+        y.y() += x.n();
+    });
+    EXPECT_EQ(cnt.size(), std::size_t(std::count(cnt.begin(), cnt.end(), 1)));
+    for (const auto& x : a) EXPECT_EQ(1100.f, x.y());
+    for (const auto& y : b) EXPECT_EQ(700 * 699 / 2, y.y());
+}
+
+TEST(SOAAlgorithms, ForEachUniquePair) {
+    using namespace Fields;
+    using C = SOA::Container<std::vector, SkinNonUnique>;
+    for (int n : {0, 1, 2, 100, 1000, 1201}) {
+        C c;
+        for (int i = 0; i < n; ++i) c.emplace_back(i, 0.f, i);
+        std::vector<int> cnt(std::size_t(n) * n, 0);
+        SOA::for_each_unique_pair(c, [&cnt, n](C::reference x,
+                                               C::reference y) {
+            EXPECT_LT(x.n(), y.n());
+            ++cnt[std::size_t(x.n()) * n + std::size_t(y.n())];
+            // Newton's third law: equal and opposite updates
+            x.y() += y.n() - x.n();
+            y.y() -= y.n() - x.n();
+        });
+        EXPECT_EQ(std::size_t(n) * (n - 1) / 2,
+                  std::size_t(std::count(cnt.begin(), cnt.end(), 1)));
+        double sum = 0;
+        for (int i = 0; i < n; ++i) {
+            // sum_j (j - i) = n (n - 1) / 2 - n i
+            EXPECT_EQ(float(n * (n - 1) / 2 - n * i), c[i].y());
+            sum += c[i].y();
+        }
+        EXPECT_EQ(0., sum);
+    }
+}
+
+/// pair loops with functors picking fields of both elements
+template <typename C>
+static void testPairFields()
+{
+    using namespace Fields;
+    for (int n : {0, 1, 2, 100, 1000, 1201}) {
+        C c;
+        for (int i = 0; i < n; ++i) c.emplace_back(i, 0.f, i);
+        SOA::for_each_unique_pair(c, [](SOA::cref<f_n> na, SOA::ref<f_y> ya,
+                                        SOA::cref<f_n> nb,
+                                        SOA::ref<f_y> yb) {
+            ya += nb - na;
+            yb -= nb - na;
+        });
+        for (int i = 0; i < n; ++i)
+            EXPECT_EQ(float(n * (n - 1) / 2 - n * i), c[i].y());
+    }
+    C a, b;
+    for (int i = 0; i < 700; ++i) a.emplace_back(i, 0.f, i);
+    for (int i = 0; i < 1100; ++i) b.emplace_back(i, 0.f, 1);
+    SOA::for_each_pair(a, b, [](SOA::cref<f_n> na, SOA::ref<f_y> ya,
+                                SOA::cref<f_n> nb, SOA::ref<f_y> yb) {
+        ya += int(nb);
+        yb += int(na);
+    });
+    for (const auto& x : a) EXPECT_EQ(1100.f, x.y());
+    for (const auto& y : b) EXPECT_EQ(700 * 699 / 2, y.y());
+    // read-only first half: a is not written to
+    const C& ca = a;
+    SOA::for_each_pair(ca, b, [](SOA::cref<f_y> ya, SOA::ref<f_y> yb) {
+        yb -= float(ya);
+    });
+    for (const auto& y : b) EXPECT_EQ(700 * 699 / 2 - 700 * 1100, y.y());
+}
+
+TEST(SOAAlgorithms, PairFields) {
+    testPairFields<SOA::Container<std::vector, Fields::SkinNonUnique> >();
+    testPairFields<
+            SOA::Container<SOA::AoSoA<8>::storage, Fields::SkinNonUnique> >();
+}
+
 TEST(SOAAlgorithms, ForeachBasicTest) {
     using namespace Fields;
     SOA::Container<std::vector, SkinUnique> c1;
@@ -115,6 +323,252 @@ TEST(SOAAlgorithms, ForeachBasicTest) {
     EXPECT_EQ(c1[3].n(), c1[3].x());
 }
 
+TEST(SOAAlgorithms, ForeachContiguous) {
+    using namespace Fields;
+    using C = SOA::Container<std::vector, SkinNonUnique>;
+    static_assert(SOA::impl_algs::raw_for_each_ok<
+                          C&, SOA::ref<f_x>, SOA::cref<f_y> >::value,
+                  "std::vector columns should use raw pointer loop");
+    C c;
+    for (int i = 0; i < 1000; ++i) c.emplace_back(0, i, i);
+    SOA::for_each(c, [](SOA::ref<f_x> x, SOA::cref<f_y> y, int n) {
+        x = 2 * y + n;
+    });
+    for (int i = 0; i < 1000; ++i) EXPECT_EQ(3.f * i, c[i].x());
+    // columns of a part of a container are (most likely) not aligned
+    auto v = SOA::view<f_x, f_n>(c, c.begin() + 1, c.begin() + 10);
+    SOA::for_each(v, [](float& x, int n) { x = -n; });
+    EXPECT_EQ(0.f, c[0].x());
+    for (int i = 1; i < 10; ++i) EXPECT_EQ(-float(i), c[i].x());
+    EXPECT_EQ(30.f, c[10].x());
+    // an empty view is fine, too
+    C e;
+    SOA::for_each(e, [](SOA::ref<f_x> x) { x = 1.f; });
+    EXPECT_TRUE(e.empty());
+}
+
+TEST(SOAAlgorithms, SortBy) {
+    using namespace Fields;
+    SOA::Container<std::vector, SkinNonUnique> c;
+    for (int i = 0; i < 100; ++i)
+        c.emplace_back((i * 37) % 100, -i, i);
+    SOA::sort_by<f_x>(c);
+    EXPECT_EQ(100u, c.size());
+    for (int i = 0; i < 100; ++i) {
+        // whole elements move together
+        EXPECT_EQ(float(i), c[i].x());
+        EXPECT_EQ(float(-c[i].n()), c[i].y());
+        EXPECT_EQ(i, (c[i].n() * 37) % 100);
+    }
+    SOA::sort_by<f_n>(c, std::greater<int>());
+    for (int i = 0; i < 100; ++i) EXPECT_EQ(99 - i, c[i].n());
+    // sorting part of a container leaves the rest alone
+    auto v = SOA::view<f_x, f_n>(c, c.begin() + 10, c.begin() + 20);
+    SOA::sort_by<f_n>(v);
+    for (int i = 0; i < 10; ++i) EXPECT_EQ(99 - i, c[i].n());
+    for (int i = 10; i < 20; ++i) EXPECT_EQ(i + 70, c[i].n());
+    for (int i = 20; i < 100; ++i) EXPECT_EQ(99 - i, c[i].n());
+}
+
+TEST(SOAAlgorithms, StableSortBy) {
+    using namespace Fields;
+    SOA::Container<std::vector, SkinUnique> c;
+    for (int i = 0; i < 100; ++i) c.emplace_back(i % 7, i);
+    SOA::stable_sort_by<f_x>(c);
+    for (int i = 1; i < 100; ++i) {
+        EXPECT_LE(c[i - 1].x(), c[i].x());
+        if (c[i - 1].x() == c[i].x()) {
+            EXPECT_LT(c[i - 1].n(), c[i].n());
+        }
+    }
+}
+
+TEST(SOAAlgorithms, RadixSortBy) {
+    using namespace Fields;
+    SOA::Container<std::vector, SkinNonUnique> c, ref;
+    for (int i = 0; i < 1000; ++i) {
+        const int n = (i * 7919) % 1000 - 500;
+        c.emplace_back(0.25f * float((i * 31) % 97 - 48), float(i),
+                       n * 1000);
+    }
+    c.emplace_back(-1e-30f, -1.f, 0);
+    c.emplace_back(std::numeric_limits<float>::max(), -2.f, 0);
+    c.emplace_back(std::numeric_limits<float>::lowest(), -3.f, 0);
+    // radix sort is stable, so results must agree with stable_sort_by
+    ref = c;
+    SOA::radix_sort_by<f_n>(c);
+    SOA::stable_sort_by<f_n>(ref);
+    for (std::size_t i = 0; i < c.size(); ++i) {
+        EXPECT_EQ(ref[i].n(), c[i].n());
+        EXPECT_EQ(ref[i].y(), c[i].y());
+    }
+    SOA::radix_sort_by<f_x>(c);
+    SOA::stable_sort_by<f_x>(ref);
+    for (std::size_t i = 0; i < c.size(); ++i) {
+        EXPECT_EQ(ref[i].x(), c[i].x());
+        EXPECT_EQ(ref[i].y(), c[i].y());
+    }
+    EXPECT_EQ(std::numeric_limits<float>::lowest(), c.front().x());
+    EXPECT_EQ(std::numeric_limits<float>::max(), c.back().x());
+    // empty views are fine, too
+    SOA::Container<std::vector, SkinNonUnique> e;
+    SOA::radix_sort_by<f_x>(e);
+    EXPECT_TRUE(e.empty());
+}
+
+TEST(SOAAlgorithms, ReorderBySpaceFillingCurve) {
+    using namespace Fields;
+    using C = SOA::Container<std::vector, SkinNonUnique>;
+    // 16 x 16 grid of points, in a scrambled order
+    C c;
+    for (int i = 0; i < 256; ++i) {
+        const int j = (i * 97) % 256;
+        c.emplace_back(j % 16, j / 16, j);
+    }
+    SOA::reorder_by_space_filling_curve<f_x, f_y>(c);
+    ASSERT_EQ(256u, c.size());
+    // Z-order: 2 x 2 blocks, then 4 x 4 blocks, ...
+    for (std::size_t i = 0; i < c.size(); i += 4) {
+        EXPECT_EQ(c[i].x(), c[i + 1].x());
+        EXPECT_EQ(c[i].y() + 1, c[i + 1].y());
+        EXPECT_EQ(c[i].x() + 1, c[i + 2].x());
+        EXPECT_EQ(c[i].y(), c[i + 2].y());
+    }
+    for (std::size_t i = 0; i < c.size(); i += 16) {
+        EXPECT_EQ(0, int(c[i].x()) % 4);
+        EXPECT_EQ(0, int(c[i].y()) % 4);
+    }
+    SOA::reorder_by_space_filling_curve<f_x, f_y>(
+            c, SOA::space_filling_curve::hilbert);
+    // Hilbert curve: consecutive points are neighbours on the grid
+    EXPECT_EQ(0.f, c[0].x());
+    EXPECT_EQ(0.f, c[0].y());
+    for (std::size_t i = 1; i < c.size(); ++i) {
+        EXPECT_EQ(1.f, std::abs(c[i].x() - c[i - 1].x()) +
+                               std::abs(c[i].y() - c[i - 1].y()));
+    }
+    // rows stay intact
+    for (const auto& el : c) EXPECT_EQ(el.n(), el.x() + 16 * el.y());
+}
+
+TEST(SOAAlgorithms, ApplyPermutation) {
+    using namespace Fields;
+    using C = SOA::Container<std::vector, SkinNonUnique>;
+    C c1, c2;
+    std::vector<std::size_t> perm;
+    for (int i = 0; i < 100; ++i) {
+        c1.emplace_back(float(i), float(-i), i);
+        // several cycles of different lengths, and some fixed points
+        perm.push_back(i % 10 ? (i / 10) * 10 + (i * 7) % 10 : i);
+    }
+    c2 = c1;
+    SOA::apply_permutation(c1, perm);
+    SOA::apply_permutation_in_place(c2, perm);
+    for (std::size_t i = 0; i < perm.size(); ++i) {
+        EXPECT_EQ(float(perm[i]), c1[i].x());
+        EXPECT_EQ(-float(perm[i]), c1[i].y());
+        EXPECT_EQ(int(perm[i]), c1[i].n());
+        EXPECT_EQ(c1[i], c2[i]);
+    }
+    // single long cycle
+    for (std::size_t i = 0; i < perm.size(); ++i)
+        perm[i] = (i + 1) % perm.size();
+    SOA::apply_permutation_in_place(c2, perm);
+    for (std::size_t i = 0; i < perm.size(); ++i)
+        EXPECT_EQ(c1[(i + 1) % c1.size()], c2[i]);
+}
+
+TEST(SOAAlgorithms, BucketBy) {
+    using namespace Fields;
+    using C = SOA::Container<std::vector, SkinNonUnique>;
+    C c;
+    for (int i = 0; i < 100; ++i) c.emplace_back(float(i), 0.f, (i * 37) % 7);
+    // bucket 5 stays empty
+    struct Func {
+        std::size_t operator()(int n) const { return n == 5 ? 4 : n; }
+    };
+    const auto offsets = SOA::bucket_by<f_n>(c, 7, Func());
+    ASSERT_EQ(8u, offsets.size());
+    EXPECT_EQ(0u, offsets[0]);
+    EXPECT_EQ(c.size(), offsets[7]);
+    EXPECT_EQ(offsets[5], offsets[6]);
+    for (std::size_t b = 0; b < 7; ++b) {
+        for (std::size_t i = offsets[b]; i != offsets[b + 1]; ++i) {
+            EXPECT_EQ(b, Func()(c[i].n()));
+            // stable: original order within the bucket
+            if (i != offsets[b]) {
+                EXPECT_LT(c[i - 1].x(), c[i].x());
+            }
+        }
+    }
+    EXPECT_EQ(28u, offsets[5] - offsets[4]);
+    C empty;
+    EXPECT_EQ(std::vector<std::size_t>(4, 0),
+              SOA::bucket_by<f_n>(empty, 3, Func()));
+    // bucket numbers out of range throw, and leave the view alone
+    C c2(c);
+    EXPECT_THROW(SOA::bucket_by<f_n>(c, 6, Func()), std::out_of_range);
+    for (std::size_t i = 0; i < c.size(); ++i) {
+        EXPECT_EQ(c2[i].x(), c[i].x());
+        EXPECT_EQ(c2[i].n(), c[i].n());
+    }
+}
+
+TEST(SOAAlgorithms, EraseIf) {
+    using namespace Fields;
+    SOA::Container<std::vector, SkinNonUnique> c;
+    for (int i = 0; i < 100; ++i) c.emplace_back(i, -i, i % 3);
+    // nothing to erase
+    EXPECT_EQ(0u, SOA::erase_if(c, [](SOA::cref<f_n> n) { return n > 2; }));
+    EXPECT_EQ(100u, c.size());
+    // erase every third element, and everything at the end
+    EXPECT_EQ(40u, SOA::erase_if(c, [](SOA::cref<f_n> n, SOA::cref<f_x> x) {
+                  return 0 == n || x >= 90.f;
+              }));
+    EXPECT_EQ(60u, c.size());
+    for (std::size_t i = 0; i < c.size(); ++i) {
+        const int j = 3 * (i / 2) + 1 + (i % 2);
+        EXPECT_EQ(float(j), c[i].x());
+        EXPECT_EQ(float(-j), c[i].y());
+        EXPECT_EQ(j % 3, c[i].n());
+    }
+    // erase everything
+    EXPECT_EQ(60u, SOA::erase_if(c, [](int) { return true; }));
+    EXPECT_TRUE(c.empty());
+}
+
+TEST(SOAAlgorithms, GatherScatter) {
+    using namespace Fields;
+    SOA::Container<std::vector, SkinNonUnique> c;
+    for (int i = 0; i < 100; ++i) c.emplace_back(i, -i, 2 * i);
+    std::vector<std::size_t> idx;
+    for (std::size_t i = 0; i < 40; ++i) idx.push_back((i * 37) % 100);
+    // into a new container
+    auto g = SOA::gather(c, idx);
+    static_assert(std::is_same<decltype(g)::fields_typelist,
+                               decltype(c)::fields_typelist>::value,
+                  "gather should return a container with the same fields");
+    EXPECT_EQ(idx.size(), g.size());
+    for (std::size_t i = 0; i < idx.size(); ++i) {
+        EXPECT_EQ(float(idx[i]), g[i].x());
+        EXPECT_EQ(-float(idx[i]), g[i].y());
+        EXPECT_EQ(2 * int(idx[i]), g[i].n());
+    }
+    // into an existing container with fewer fields
+    SOA::Container<std::vector, SkinUnique> u(3);
+    SOA::gather(c, std::vector<unsigned>{ 5, 1, 9 }, u);
+    EXPECT_EQ(5.f, u[0].x());
+    EXPECT_EQ(18, u[2].n());
+    // scatter back, modified, and the original gets updated
+    for (auto el : g) el.y() = 1000.f;
+    SOA::scatter(SOA::view<f_y>(g), idx, c);
+    for (std::size_t i = 0; i < 100; ++i) {
+        const bool hit = idx.end() != std::find(idx.begin(), idx.end(), i);
+        EXPECT_EQ(hit ? 1000.f : -float(i), c[i].y());
+        EXPECT_EQ(float(i), c[i].x());
+    }
+}
+
 /* Copyright (C) CERN for the benefit of the LHCb collaboration
  *
  * This program is free software: you can redistribute it and/or modify
@@ -0,0 +1,201 @@
+/** @file tests/SOACellList.cc
+ *
+ * @brief test SOA::CellList
+ *
+ * For copyright and license information, see the end of the file.
+ */
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "SOACellList.h"
+
+namespace CellFields {
+    SOAFIELD_TRIVIAL(f_x, x, float);
+    SOAFIELD_TRIVIAL(f_y, y, float);
+    SOAFIELD_TRIVIAL(f_z, z, float);
+    SOAFIELD_TRIVIAL(f_id, id, int);
+    SOASKIN_TRIVIAL(Skin, f_x, f_y, f_z, f_id);
+} // namespace CellFields
+
+using Hits = SOA::Container<std::vector, CellFields::Skin>;
+
+static Hits makeHits(std::size_t n)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> u(-10.f, 10.f);
+    Hits hits;
+    for (std::size_t i = 0; i < n; ++i)
+        hits.emplace_back(u(rng), u(rng), u(rng), int(i));
+    return hits;
+}
+
+/// rows near p according to the cell list
+template <typename GRID>
+static std::vector<int> near(const GRID& grid, const Hits& hits,
+                             const typename GRID::point_type& p, float r,
+                             float (*dist2)(const Hits::const_reference&,
+                                            const typename GRID::point_type&))
+{
+    std::vector<int> retVal;
+    grid.for_each_neighbour_range(
+            p, [&](std::size_t first, std::size_t last) {
+                EXPECT_LT(first, last);
+                for (std::size_t i = first; i != last; ++i)
+                    if (dist2(hits[i], p) < r * r)
+                        retVal.push_back(hits[i].id());
+            });
+    std::sort(retVal.begin(), retVal.end());
+    return retVal;
+}
+
+/// rows near p by brute force
+template <typename POINT>
+static std::vector<int> nearBrute(const Hits& hits, const POINT& p, float r,
+                                  float (*dist2)(const Hits::const_reference&,
+                                                 const POINT&))
+{
+    std::vector<int> retVal;
+    for (const auto& h : hits)
+        if (dist2(h, p) < r * r) retVal.push_back(h.id());
+    std::sort(retVal.begin(), retVal.end());
+    return retVal;
+}
+
+static float dist2_2d(const Hits::const_reference& h,
+                      const std::array<float, 2>& p)
+{
+    return (h.x() - p[0]) * (h.x() - p[0]) + (h.y() - p[1]) * (h.y() - p[1]);
+}
+
+static float dist2_3d(const Hits::const_reference& h,
+                      const std::array<float, 3>& p)
+{
+    return (h.x() - p[0]) * (h.x() - p[0]) +
+           (h.y() - p[1]) * (h.y() - p[1]) + (h.z() - p[2]) * (h.z() - p[2]);
+}
+
+TEST(SOACellList, Grid2D)
+{
+    using namespace CellFields;
+    Hits hits = makeHits(5000);
+    const Hits orig(hits);
+    const float r = 0.5f;
+    SOA::CellList<f_x, f_y> grid(hits, r);
+    EXPECT_LE(r, grid.cell_size());
+    EXPECT_EQ(grid.ncells(), grid.ncells(0) * grid.ncells(1));
+    // rows are a permutation of the original ones, sorted by cell
+    ASSERT_EQ(orig.size(), hits.size());
+    std::size_t lastcell = 0;
+    for (const auto& h : hits) {
+        const auto& o = orig[h.id()];
+        EXPECT_EQ(o.x(), h.x());
+        EXPECT_EQ(o.y(), h.y());
+        EXPECT_EQ(o.z(), h.z());
+        const std::size_t cell = grid.cell_index({{h.x(), h.y()}});
+        EXPECT_LE(lastcell, cell);
+        lastcell = cell;
+    }
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> u(-11.f, 11.f);
+    for (int i = 0; i < 200; ++i) {
+        const std::array<float, 2> p{{u(rng), u(rng)}};
+        EXPECT_EQ(nearBrute(hits, p, r, dist2_2d),
+                  near(grid, hits, p, r, dist2_2d));
+    }
+}
+
+TEST(SOACellList, Grid3D)
+{
+    using namespace CellFields;
+    Hits hits = makeHits(3000);
+    const float r = 1.5f;
+    SOA::CellList<f_x, f_y, f_z> grid(hits, r);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> u(-10.f, 10.f);
+    for (int i = 0; i < 200; ++i) {
+        const std::array<float, 3> p{{u(rng), u(rng), u(rng)}};
+        EXPECT_EQ(nearBrute(hits, p, r, dist2_3d),
+                  near(grid, hits, p, r, dist2_3d));
+    }
+}
+
+TEST(SOACellList, Degenerate)
+{
+    using namespace CellFields;
+    Hits hits;
+    SOA::CellList<f_x, f_y> empty(hits, 1.f);
+    EXPECT_EQ(1u, empty.ncells());
+    std::size_t calls = 0;
+    empty.for_each_neighbour_range(
+            {{0.f, 0.f}}, [&calls](std::size_t, std::size_t) { ++calls; });
+    EXPECT_EQ(0u, calls);
+    // tiny cells get enlarged
+    hits = makeHits(100);
+    SOA::CellList<f_x, f_y, f_z> grid(hits, 1e-6f);
+    EXPECT_GE(4u * hits.size(), grid.ncells());
+    SOA::CellList<f_x> grid1d(hits, 0.f);
+    EXPECT_GE(4u * hits.size(), grid1d.ncells());
+    for (const auto& h : hits) {
+        calls = 0;
+        grid1d.for_each_neighbour_range(
+                {{h.x()}}, [&calls](std::size_t, std::size_t) { ++calls; });
+        EXPECT_EQ(1u, calls);
+    }
+}
+
+TEST(SOACellList, NonFinite)
+{
+    using namespace CellFields;
+    for (float bad : {std::numeric_limits<float>::infinity(),
+                      -std::numeric_limits<float>::infinity(),
+                      std::numeric_limits<float>::quiet_NaN()}) {
+        // bad value in the first row and in a later row
+        for (std::size_t row : {0u, 50u}) {
+            Hits hits = makeHits(100);
+            hits[row].y() = bad;
+            EXPECT_THROW((SOA::CellList<f_x, f_y>(hits, 1.f)),
+                         std::domain_error);
+        }
+    }
+    // finite coordinates spanning more than the range of float
+    Hits hits;
+    const float big = std::numeric_limits<float>::max();
+    hits.emplace_back(-big, 0.f, 0.f, 0);
+    hits.emplace_back(big, 0.f, 0.f, 1);
+    hits.emplace_back(0.f, 0.f, 0.f, 2);
+    SOA::CellList<f_x> grid(hits, 1.f);
+    EXPECT_GE(4u * hits.size(), grid.ncells());
+    std::size_t rows = 0;
+    grid.for_each_neighbour_range(
+            {{big}}, [&rows](std::size_t first, std::size_t last) {
+                rows += last - first;
+            });
+    EXPECT_EQ(hits.size(), rows);
+}
+
+/* Copyright (C) CERN for the benefit of the LHCb collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In applying this licence, CERN does not waive the privileges and immunities
+ * granted to it by virtue of its status as an Intergovernmental Organization
+ * or submit itself to any jurisdiction.
+ */
+
+// vim: sw=4:tw=78:ft=cpp:et
@@ -0,0 +1,162 @@
+/** @file tests/SOAContainerAppend.cc
+ *
+ * @brief test append(view) and append_columns(ptrs..., n)
+ *
+ * For copyright and license information, see the end of the file.
+ */
+
+#include <deque>
+#include <tuple>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "SOAContainer.h"
+#include "SOASlabStorage.h"
+#include "SOAAoSoAStorage.h"
+
+namespace AppendFields {
+    SOAFIELD_TRIVIAL(f_x, x, float);
+    SOAFIELD_TRIVIAL(f_y, y, float);
+    SOAFIELD_TRIVIAL(f_n, n, int);
+    SOASKIN_TRIVIAL(Skin, f_x, f_n);
+    SOASKIN_TRIVIAL(BigSkin, f_n, f_y, f_x);
+} // namespace AppendFields
+
+template <typename CONT>
+static void testAppend()
+{
+    using namespace AppendFields;
+    CONT c;
+    c.emplace_back(-1.f, -1);
+    // from plain arrays
+    const float xs[] = { 0.f, 1.f, 2.f, 3.f, 4.f };
+    const int ns[] = { 0, 10, 20, 30, 40 };
+    auto it = c.append_columns(xs, ns, 5);
+    EXPECT_EQ(6u, c.size());
+    EXPECT_EQ(c.begin() + 1, it);
+    for (unsigned i = 0; i < 5; ++i) {
+        EXPECT_EQ(xs[i], c[i + 1].x());
+        EXPECT_EQ(ns[i], c[i + 1].n());
+    }
+    // from a container with a different storage, but the same fields
+    SOA::Container<std::vector, Skin> other;
+    for (int i = 0; i < 100; ++i) other.emplace_back(float(i), -i);
+    it = c.append(other);
+    EXPECT_EQ(106u, c.size());
+    EXPECT_EQ(c.begin() + 6, it);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(float(i), c[i + 6].x());
+        EXPECT_EQ(-i, c[i + 6].n());
+    }
+    // from part of a container with more fields in a different order
+    SOA::Container<std::vector, BigSkin> big;
+    for (int i = 0; i < 10; ++i) big.emplace_back(i, 0.5f, 2.f * i);
+    c.append(SOA::view<f_x, f_n>(big, big.begin() + 2, big.begin() + 7));
+    EXPECT_EQ(111u, c.size());
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(2.f * (i + 2), c[i + 106].x());
+        EXPECT_EQ(i + 2, c[i + 106].n());
+    }
+    c.append(big);
+    EXPECT_EQ(121u, c.size());
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(2.f * i, c[i + 111].x());
+        EXPECT_EQ(i, c[i + 111].n());
+    }
+    // nothing to append
+    c.append(SOA::Container<std::vector, Skin>());
+    EXPECT_EQ(121u, c.size());
+    EXPECT_EQ(-1.f, c.front().x());
+}
+
+TEST(SOAContainerAppend, Vector)
+{ testAppend<SOA::Container<std::vector, AppendFields::Skin> >(); }
+
+TEST(SOAContainerAppend, Deque)
+{ testAppend<SOA::Container<std::deque, AppendFields::Skin> >(); }
+
+TEST(SOAContainerAppend, Slab)
+{ testAppend<SOA::Container<SOA::SlabStorage, AppendFields::Skin> >(); }
+
+TEST(SOAContainerAppend, AoSoA)
+{ testAppend<SOA::Container<SOA::AoSoA<8>::storage, AppendFields::Skin> >(); }
+
+/// appending grows the container only once
+TEST(SOAContainerAppend, SingleGrowth)
+{
+    SOA::Container<std::vector, AppendFields::Skin> c, other;
+    for (int i = 0; i < 1000; ++i) other.emplace_back(float(i), i);
+    c.append(other);
+    EXPECT_EQ(1000u, c.size());
+    EXPECT_EQ(1000u, c.capacity());
+}
+
+/// append copies of our own elements, at full capacity, too
+template <typename CONT>
+static void testSelfAppend()
+{
+    using namespace AppendFields;
+    CONT c;
+    std::vector<float> xs(1, 0.5f);
+    std::vector<int> ns(1, 1);
+    c.emplace_back(xs[0], ns[0]);
+    std::size_t nfull = 0;
+    for (std::size_t i = 1; i < 1000; ++i) {
+        const std::size_t j = i / 2;
+        if (c.size() == c.capacity()) ++nfull;
+        switch (i % 4) {
+            case 0: c.emplace_back(c[j].x(), c[j].n()); break;
+            case 1: c.push_back(std::tie(c[j].x(), c[j].n())); break;
+            case 2:
+                c.emplace_back(std::forward_as_tuple(c[j].x(), c[j].n()));
+                break;
+            default:
+                c.emplace_back(SOA::cref<f_n>(c[j].n()),
+                               SOA::cref<f_x>(c[j].x()));
+                break;
+        }
+        xs.push_back(xs[j]);
+        ns.push_back(ns[j]);
+        // make the elements differ
+        c.back().x() += float(i);
+        c.back().n() -= int(i);
+        xs.back() += float(i);
+        ns.back() -= int(i);
+    }
+    EXPECT_LT(0u, nfull);
+    ASSERT_EQ(xs.size(), c.size());
+    for (std::size_t i = 0; i < c.size(); ++i) {
+        EXPECT_EQ(xs[i], c[i].x());
+        EXPECT_EQ(ns[i], c[i].n());
+    }
+}
+
+TEST(SOAContainerAppend, SelfAppend)
+{
+    testSelfAppend<SOA::Container<std::vector, AppendFields::Skin> >();
+    testSelfAppend<SOA::Container<SOA::SlabStorage, AppendFields::Skin> >();
+    testSelfAppend<
+            SOA::Container<SOA::AoSoA<8>::storage, AppendFields::Skin> >();
+}
+
+/* Copyright (C) CERN for the benefit of the LHCb collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In applying this licence, CERN does not waive the privileges and immunities
+ * granted to it by virtue of its status as an Intergovernmental Organization
+ * or submit itself to any jurisdiction.
+ */
+
+// vim: sw=4:tw=78:ft=cpp:et
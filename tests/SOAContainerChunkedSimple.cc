@@ -0,0 +1,481 @@
+/** @file tests/SOAContainerChunkedSimple.cc
+ *
+ * @brief some very basic SOA::Container tests, based on SOA::Chunked
+ *
+ * For copyright and license information, see the end of the file.
+ */
+
+#include <cstdint>
+#include <tuple>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+#include "gtest/gtest.h"
+#include "SOAContainer.h"
+#include "SOAAlgorithms.h"
+#include "SOAChunkedStorage.h"
+
+/// small chunks, so the tests cross chunk boundaries
+using Chunked = SOA::Chunked<16>;
+
+/// unit test Container class
+TEST(SOAContainerChunkedSimple, IteratorsSizeEmpty)
+{
+    SOA::Container<Chunked::storage, SOA::PrintableNullSkin, double, int,
+                   int> c;
+    EXPECT_EQ(SOA::Utils::is_view<decltype(c)>::value, true);
+    EXPECT_EQ(SOA::Utils::is_container<decltype(c)>::value, true);
+    const SOA::Container<Chunked::storage, SOA::PrintableNullSkin, double,
+                         int, int>& cc = c;
+    // check basic properties
+    EXPECT_TRUE(c.empty());
+    EXPECT_EQ(0u, c.size());
+    c.clear();
+    EXPECT_LE(1u, c.max_size());
+    EXPECT_LE(0u, c.capacity());
+    // reserve space
+    c.reserve(64);
+    EXPECT_LE(64u, c.capacity());
+    EXPECT_LE(c.capacity(), c.max_size());
+    // check iterators
+    EXPECT_FALSE(c.begin());
+    EXPECT_EQ(c.begin(), c.end());
+    EXPECT_EQ(cc.begin(), cc.end());
+    EXPECT_EQ(c.begin(), cc.begin());
+    EXPECT_LE(c.begin(), c.end());
+    EXPECT_LE(cc.begin(), cc.end());
+    EXPECT_LE(c.begin(), cc.begin());
+    EXPECT_GE(c.begin(), c.end());
+    EXPECT_GE(cc.begin(), cc.end());
+    // check reverse iterators
+    EXPECT_GE(c.rbegin(), cc.rbegin());
+    EXPECT_EQ(c.rbegin(), c.rend());
+    EXPECT_EQ(cc.rbegin(), cc.rend());
+    EXPECT_EQ(c.rbegin(), cc.rbegin());
+    EXPECT_LE(c.rbegin(), c.rend());
+    EXPECT_LE(cc.rbegin(), cc.rend());
+    EXPECT_LE(c.rbegin(), cc.rbegin());
+    EXPECT_GE(c.rbegin(), c.rend());
+    EXPECT_GE(cc.rbegin(), cc.rend());
+    EXPECT_GE(c.rbegin(), cc.rbegin());
+    // test at
+    EXPECT_THROW(c.at(0), std::out_of_range);
+}
+
+TEST(SOAContainerChunkedSimple, BasicPushPopInsert)
+{
+    SOA::Container<Chunked::storage, SOA::PrintableNullSkin, double, int,
+                   int> c;
+    const SOA::Container<Chunked::storage, SOA::PrintableNullSkin, double,
+                         int, int>& cc = c;
+    std::tuple<double, int, int> val(3.14, 17, 42);
+    // standard push_back by const reference
+    c.push_back(val);
+    EXPECT_FALSE(c.empty());
+    EXPECT_EQ(1u, c.size());
+
+    // After this, Clang fails
+    EXPECT_EQ(c.front(), c.back());
+    EXPECT_EQ(c.end(), 1 + c.begin());
+    EXPECT_EQ(c.rend(), 1 + c.rbegin());
+    EXPECT_EQ(&c.front(), c.begin());
+    EXPECT_EQ(&cc.front(), c.cbegin());
+    const decltype(val) val2(c.front());
+    EXPECT_EQ(val, val2);
+
+    // trigger the move-variant of push_back
+    c.push_back(std::make_tuple(2.79, 42, 17));
+
+    EXPECT_EQ(2u, c.size());
+    EXPECT_NE(c.front(), c.back());
+    EXPECT_EQ(c.end(), 2 + c.begin());
+    EXPECT_EQ(c.rend(), 2 + c.rbegin());
+    // test pop_back
+    c.pop_back();
+    EXPECT_EQ(1u, c.size());
+    // start testing plain and simple insert
+    std::tuple<double, int, int> val3(2.79, 42, 17);
+    auto it = c.insert(c.begin(), val3);
+    EXPECT_EQ(2u, c.size());
+    EXPECT_EQ(it, c.begin());
+    const decltype(val) val4(c.front()), val5(c.back());
+    EXPECT_EQ(val3, val4);
+    EXPECT_EQ(val, val5);
+    c.insert(1 + c.cbegin(), std::make_tuple(2.79, 42, 17));
+    EXPECT_EQ(3u, c.size());
+    const decltype(val) val6(c[0]), val7(c[1]);
+    EXPECT_EQ(val3, val6);
+    EXPECT_EQ(val3, val7);
+
+    EXPECT_FALSE(c.empty());
+    auto oldcap = c.capacity();
+    EXPECT_GT(oldcap, 0u);
+    c.clear();
+    EXPECT_TRUE(c.empty());
+    EXPECT_EQ(oldcap, c.capacity()); // Used to be a bug!
+    c.insert(c.begin(), oldcap, std::make_tuple(3.14, 42, 17));
+    EXPECT_EQ(oldcap, c.size());
+    // check if they're all the same
+    EXPECT_EQ(oldcap,
+              static_cast<decltype(oldcap)>(std::count_if(
+                      std::begin(c), std::end(c),
+                      [](decltype(c)::const_reference obj) {
+                          return (obj == std::make_tuple(3.14, 42, 17));
+                      })));
+    // check the other variants of comparison operators
+    EXPECT_EQ(oldcap,
+              static_cast<decltype(oldcap)>(std::count_if(
+                      std::begin(c), std::end(c),
+                      [](decltype(c)::const_reference obj) {
+                          return (std::make_tuple(3.14, 42, 17) == obj);
+                      })));
+    // check if they're all >=
+    EXPECT_EQ(oldcap,
+              static_cast<decltype(oldcap)>(std::count_if(
+                      std::begin(c), std::end(c),
+                      [](decltype(c)::const_reference obj) {
+                          return (obj >= std::make_tuple(3.14, 42, 17));
+                      })));
+    // check the other variants of comparison operators
+    EXPECT_EQ(oldcap,
+              static_cast<decltype(oldcap)>(std::count_if(
+                      std::begin(c), std::end(c),
+                      [](decltype(c)::const_reference obj) {
+                          return (std::make_tuple(3.14, 42, 17) >= obj);
+                      })));
+    // check if they're all <=
+    EXPECT_EQ(oldcap,
+              static_cast<decltype(oldcap)>(std::count_if(
+                      std::begin(c), std::end(c),
+                      [](decltype(c)::const_reference obj) {
+                          return (obj <= std::make_tuple(3.14, 42, 17));
+                      })));
+    // check the other variants of comparison operators
+    EXPECT_EQ(oldcap,
+              static_cast<decltype(oldcap)>(std::count_if(
+                      std::begin(c), std::end(c),
+                      [](decltype(c)::const_reference obj) {
+                          return (std::make_tuple(3.14, 42, 17) <= obj);
+                      })));
+    // check if none are <
+    EXPECT_EQ(0u, static_cast<decltype(oldcap)>(std::count_if(
+                          std::begin(c), std::end(c),
+                          [](decltype(c)::const_reference obj) {
+                              return (obj < std::make_tuple(3.14, 42, 17));
+                          })));
+    // check the other variants of comparison operators
+    EXPECT_EQ(0u, static_cast<decltype(oldcap)>(std::count_if(
+                          std::begin(c), std::end(c),
+                          [](decltype(c)::const_reference obj) {
+                              return (std::make_tuple(3.14, 42, 17) < obj);
+                          })));
+    // check if none are >
+    EXPECT_EQ(0u, static_cast<decltype(oldcap)>(std::count_if(
+                          std::begin(c), std::end(c),
+                          [](decltype(c)::const_reference obj) {
+                              return (obj > std::make_tuple(3.14, 42, 17));
+                          })));
+    // check the other variants of comparison operators
+    EXPECT_EQ(0u, static_cast<decltype(oldcap)>(std::count_if(
+                          std::begin(c), std::end(c),
+                          [](decltype(c)::const_reference obj) {
+                              return (std::make_tuple(3.14, 42, 17) > obj);
+                          })));
+}
+
+TEST(SOAContainerChunkedSimple, WithSTLAlgorithms)
+{
+    SOA::Container<Chunked::storage, SOA::PrintableNullSkin, double, int,
+                   int> c;
+    const SOA::Container<Chunked::storage, SOA::PrintableNullSkin, double,
+                         int, int>& cc = c;
+    // test insert(pos, first, last), erase(pos) and erase(first, last)
+    // by comparing to an array-of-structures in a std::vector
+    typedef std::size_t size_type;
+    EXPECT_TRUE(c.empty());
+    std::tuple<double, int, int> val(3.14, 0, 63);
+    std::vector<std::tuple<double, int, int>> temp;
+    temp.reserve(64);
+    for (int i = 0; i < 64; ++i) {
+        std::get<1>(val) = i;
+        std::get<2>(val) = 63 - i;
+        temp.push_back(val);
+    }
+    auto it = c.insert(c.begin(), temp.cbegin(), temp.cend());
+    EXPECT_EQ(c.begin(), it);
+    EXPECT_EQ(64u, c.size());
+    EXPECT_EQ(c.size(), temp.size());
+    EXPECT_EQ(temp.size(),
+              std::inner_product(
+                      c.begin(), c.end(), temp.begin(), size_type(0),
+                      [](size_type a, size_type b) { return a + b; },
+                      [](const decltype(val)& a, const decltype(val)& b) {
+                          return size_type(a == b);
+                      }));
+
+    // erase(pos)
+    auto jt = temp.erase(temp.begin() + 3);
+    EXPECT_EQ(temp.begin() + 3, jt);
+    auto kt = c.erase(c.begin() + 3);
+    EXPECT_EQ(c.begin() + 3, kt);
+    EXPECT_EQ(c.size(), temp.size());
+    EXPECT_EQ(temp.size(),
+              std::inner_product(
+                      c.begin(), c.end(), temp.begin(), size_type(0),
+                      [](size_type a, size_type b) { return a + b; },
+                      [](const decltype(val)& a, const decltype(val)& b) {
+                          return size_type(a == b);
+                      }));
+
+    // erase(first, last)
+    auto lt = temp.erase(temp.begin() + 5, temp.begin() + 10);
+    EXPECT_EQ(temp.begin() + 5, lt);
+    auto mt = c.erase(c.begin() + 5, c.begin() + 10);
+    EXPECT_EQ(c.begin() + 5, mt);
+    EXPECT_EQ(c.size(), temp.size());
+    EXPECT_EQ(temp.size(),
+              std::inner_product(
+                      c.begin(), c.end(), temp.begin(), size_type(0),
+                      [](size_type a, size_type b) { return a + b; },
+                      [](const decltype(val)& a, const decltype(val)& b) {
+                          return size_type(a == b);
+                      }));
+
+    // test sort (and swap)
+    EXPECT_TRUE(std::is_sorted(c.begin(), c.end(),
+                               [](decltype(c)::value_const_reference a,
+                                  decltype(c)::value_const_reference b) {
+                                   return a.get<1>() < b.get<1>();
+                               }));
+
+    std::sort(c.begin(), c.end(),
+              [](decltype(c)::value_const_reference a,
+                 decltype(c)::value_const_reference b) {
+                  return a.get<1>() > b.get<1>();
+              });
+
+    std::sort(temp.begin(), temp.end(),
+              [](const decltype(temp)::value_type& a,
+                 const decltype(temp)::value_type& b) {
+                  return std::get<1>(a) > std::get<1>(b);
+              });
+
+    EXPECT_TRUE(std::is_sorted(c.begin(), c.end(),
+                               [](decltype(c)::value_const_reference a,
+                                  decltype(c)::value_const_reference b) {
+                                   return a.get<1>() > b.get<1>();
+                               }));
+    EXPECT_TRUE(std::is_sorted(temp.begin(), temp.end(),
+                               [](const decltype(temp)::value_type& a,
+                                  const decltype(temp)::value_type& b) {
+                                   return std::get<1>(a) > std::get<1>(b);
+                               }));
+
+    EXPECT_EQ(c.size(), temp.size());
+    EXPECT_EQ(temp.size(),
+              std::inner_product(
+                      c.begin(), c.end(), temp.begin(), size_type(0),
+                      [](size_type a, size_type b) { return a + b; },
+                      [](const decltype(val)& a, const decltype(val)& b) {
+                          return size_type(a == b);
+                      }));
+
+    // test the begin<fieldno> and end<fieldno> calls (as for std::deque,
+    // end and rend must not be dereferenced)
+    EXPECT_EQ(&(*c.begin<0>()), &((*c.begin()).get<0>()));
+    EXPECT_EQ(&(*cc.begin<0>()), &((*cc.begin()).get<0>()));
+    EXPECT_EQ(&(*c.cbegin<0>()), &((*c.cbegin()).get<0>()));
+    EXPECT_EQ(&(*(c.end<0>() - 1)), &((*(c.end() - 1)).get<0>()));
+    EXPECT_EQ(&(*(cc.end<0>() - 1)), &((*(cc.end() - 1)).get<0>()));
+
+    // test (some of) the rbegin<fieldno> and rend<fieldno> calls
+    EXPECT_EQ(&(*c.rbegin<0>()), &((*c.rbegin()).get<0>()));
+    EXPECT_EQ(&(*(c.rend<0>() - 1)), &((*(c.rend() - 1)).get<0>()));
+
+    // test the begin<fieldtag> and end<fieldtag> calls
+    EXPECT_EQ(&(*c.begin<double>()), &((*c.begin()).get<double>()));
+    EXPECT_EQ(&(*cc.begin<double>()), &((*cc.begin()).get<double>()));
+    EXPECT_EQ(&(*c.cbegin<double>()), &((*c.cbegin()).get<double>()));
+    EXPECT_EQ(&(*(c.end<double>() - 1)),
+              &((*(c.end() - 1)).get<double>()));
+
+    // test (some of) the rbegin<fieldno> and rend<fieldno> calls
+    EXPECT_EQ(&(*c.rbegin<double>()), &((*c.rbegin()).get<double>()));
+
+    // rudimentary tests of comparison of containers
+    decltype(c) d;
+    decltype(temp) temp2;
+    EXPECT_EQ(c, c);
+    EXPECT_EQ(temp, temp);
+    EXPECT_NE(c, d);
+    EXPECT_NE(temp, temp2);
+    EXPECT_LT(d, c);
+    EXPECT_LT(temp2, temp);
+    EXPECT_LE(c, c);
+    EXPECT_LE(temp, temp);
+    EXPECT_GE(c, c);
+    EXPECT_GE(temp, temp);
+
+    {
+        // test assign(count, val)
+        c.assign(42, std::make_tuple(3.14, 0, -1));
+        EXPECT_EQ(42u, c.size());
+        EXPECT_EQ(c.size(),
+                  std::size_t(std::count(std::begin(c), std::end(c),
+                                         std::make_tuple(3.14, 0, -1))));
+        // assign(first, last) is just a frontend for clear(); insert(front,
+        // end); - therefore, no test here
+    }
+    {
+        // test emplace, emplace_back, resize
+        c.clear();
+        auto ref = c.emplace_back(2.79, 42, 17);
+        EXPECT_EQ(1u, c.size());
+        EXPECT_EQ(c.front(), std::make_tuple(2.79, 42, 17));
+        EXPECT_EQ(&c.back(), &ref);
+        auto it = c.emplace(c.begin(), 2.79, 17, 42);
+        EXPECT_EQ(2u, c.size());
+        EXPECT_EQ(c.begin(), it);
+        EXPECT_EQ(c.front(), std::make_tuple(2.79, 17, 42));
+        EXPECT_EQ(c.back(), std::make_tuple(2.79, 42, 17));
+        c.resize(64, std::make_tuple(3.14, 78, 17));
+        EXPECT_EQ(64u, c.size());
+        EXPECT_EQ(c.back(), std::make_tuple(3.14, 78, 17));
+        c.emplace_back(std::make_tuple(42., 42, 42));
+        EXPECT_EQ(c.back(), std::make_tuple(42., 42, 42));
+        c.emplace(c.begin(), std::make_tuple(17., 42, 42));
+        EXPECT_EQ(c.front(), std::make_tuple(17., 42, 42));
+        c.resize(0);
+        EXPECT_TRUE(c.empty());
+        c.resize(32);
+        EXPECT_EQ(32u, c.size());
+        const std::tuple<double, int, int> defaultval;
+        EXPECT_EQ(c.back(), defaultval);
+    }
+}
+
+
+/// growth adds chunks, and never moves elements
+TEST(SOAContainerChunkedSimple, StableAddresses)
+{
+    SOA::Container<Chunked::storage, SOA::NullSkin, double, int> c;
+    c.emplace_back(0., 0);
+    const double* p0 = &*c.begin<0>();
+    const int* p1 = &*c.begin<1>();
+    std::vector<const double*> addr;
+    for (int i = 1; i < 1000; ++i) {
+        c.emplace_back(0.5 * i, i);
+        // grows by one chunk at a time, not geometrically
+        EXPECT_EQ((c.size() + 15) / 16 * 16, c.capacity());
+        if (i % 16 == 0) addr.push_back(&*(c.begin<0>() + i));
+    }
+    EXPECT_EQ(p0, &*c.begin<0>());
+    EXPECT_EQ(p1, &*c.begin<1>());
+    for (std::size_t k = 0; k < addr.size(); ++k) {
+        EXPECT_EQ(addr[k], &*(c.begin<0>() + 16 * (k + 1)));
+        // chunks are cache line aligned
+        EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(addr[k]) % 64);
+    }
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_EQ(std::make_tuple(0.5 * i, i), c[i]);
+    // erase and insert across chunk boundaries
+    c.erase(c.begin() + 10, c.begin() + 50);
+    c.insert(c.begin() + 5, 20, std::make_tuple(-1., -1));
+    ASSERT_EQ(980u, c.size());
+    for (int i = 0; i < 980; ++i) {
+        const int j = i < 5 ? i : i < 25 ? -1 : i < 30 ? i - 20 : i + 20;
+        EXPECT_EQ(std::make_tuple(j < 0 ? -1. : 0.5 * j, j), c[i]);
+    }
+    c.erase(c.begin() + 100, c.end());
+    c.shrink_to_fit();
+    EXPECT_EQ(112u, c.capacity());
+}
+
+/// copies, moves and swaps
+TEST(SOAContainerChunkedSimple, CopyMoveSwap)
+{
+    using cont_t = SOA::Container<Chunked::storage, SOA::NullSkin, double,
+                                  int>;
+    cont_t c;
+    for (int i = 0; i < 42; ++i) c.emplace_back(i, -i);
+    cont_t d(c);
+    EXPECT_EQ(c, d);
+    EXPECT_NE(&*c.begin<0>(), &*d.begin<0>());
+    d.emplace_back(42, -42);
+    EXPECT_EQ(42u, c.size());
+    EXPECT_EQ(43u, d.size());
+    const double* p = &*d.begin<0>();
+    cont_t e(std::move(d));
+    EXPECT_EQ(p, &*e.begin<0>());
+    EXPECT_EQ(43u, e.size());
+    EXPECT_TRUE(d.empty());
+    d = c;
+    EXPECT_EQ(c, d);
+    e.swap(d);
+    EXPECT_EQ(42u, e.size());
+    EXPECT_EQ(43u, d.size());
+    EXPECT_EQ(p, &*d.begin<0>());
+    // the moved/swapped containers must still be usable
+    for (int i = 43; i < 1000; ++i) d.emplace_back(i, -i);
+    for (int i = 0; i < 1000; ++i) EXPECT_EQ(-i, d[i].get<1>());
+    e = std::move(d);
+    EXPECT_EQ(1000u, e.size());
+}
+
+namespace ChunkedFields {
+    SOAFIELD_TRIVIAL(f_x, x, float);
+    SOAFIELD_TRIVIAL(f_y, y, float);
+    SOAFIELD_TRIVIAL(f_n, n, char);
+    SOASKIN_TRIVIAL(Skin, f_x, f_y, f_n);
+    SOAFIELD_TRIVIAL(f_sum, sum, float);
+} // namespace ChunkedFields
+
+/// algorithms work chunk by chunk
+TEST(SOAContainerChunkedSimple, Algorithms)
+{
+    using namespace ChunkedFields;
+    SOA::Container<Chunked::storage, Skin> c;
+    static_assert(SOA::impl::is_segmented_iterator<
+                          decltype(c.begin<f_x>())>::value,
+                  "chunked iterators should be segmented");
+    for (int i = 0; i < 1000; ++i) c.emplace_back(i, 2.f * i, char(i));
+    SOA::for_each(c, [](SOA::ref<f_x> x, SOA::cref<f_y> y) {
+        x += float(y);
+    });
+    struct Sum {
+        SOA::value<f_sum> operator()(SOA::cref<f_x> x,
+                                     SOA::cref<f_n> n) const
+        { return x + n; }
+    };
+    const auto s = SOA::transform(c, Sum());
+    ASSERT_EQ(1000u, s.size());
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(3.f * i, c[i].x());
+        EXPECT_EQ(3.f * i + char(i), s[i].sum());
+    }
+    SOA::radix_sort_by<f_n>(c);
+    for (std::size_t i = 1; i < c.size(); ++i)
+        EXPECT_LE(c[i - 1].n(), c[i].n());
+}
+/* Copyright (C) CERN for the benefit of the LHCb collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In applying this licence, CERN does not waive the privileges and immunities
+ * granted to it by virtue of its status as an Intergovernmental Organization
+ * or submit itself to any jurisdiction.
+ */
+
+// vim: sw=4:tw=78:ft=cpp:et
@@ -0,0 +1,111 @@
+/** @file tests/SOAContainerDefaultInit.cc
+ *
+ * @brief test resize_default_init and append_uninitialized
+ *
+ * For copyright and license information, see the end of the file.
+ */
+
+#include <deque>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "SOAContainer.h"
+#include "SOASlabStorage.h"
+#include "SOAAoSoAStorage.h"
+
+namespace DefaultInitFields {
+    SOAFIELD_TRIVIAL(f_x, x, float);
+    SOAFIELD_TRIVIAL(f_n, n, int);
+    SOASKIN_TRIVIAL(Skin, f_x, f_n);
+} // namespace DefaultInitFields
+
+template <typename CONT>
+static void testAppendUninitialized()
+{
+    CONT c;
+    for (int i = 0; i < 10; ++i) c.emplace_back(i, i);
+    auto tail = c.append_uninitialized(100);
+    EXPECT_EQ(110u, c.size());
+    EXPECT_EQ(100u, tail.size());
+    // the view refers to the new elements in the container
+    EXPECT_EQ(&c[10].x(), &tail[0].x());
+    EXPECT_EQ(&c[109].n(), &tail[99].n());
+    for (auto el : tail) el.x() = 42.f, el.n() = -1;
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(float(i), c[i].x());
+        EXPECT_EQ(i, c[i].n());
+    }
+    for (int i = 10; i < 110; ++i) {
+        EXPECT_EQ(42.f, c[i].x());
+        EXPECT_EQ(-1, c[i].n());
+    }
+    // shrinking gives an empty view
+    auto none = c.resize_default_init(5);
+    EXPECT_EQ(5u, c.size());
+    EXPECT_TRUE(none.empty());
+    // growing again gives a view of the new tail
+    auto more = c.resize_default_init(20);
+    EXPECT_EQ(20u, c.size());
+    EXPECT_EQ(15u, more.size());
+    EXPECT_EQ(&c[5].x(), &more[0].x());
+}
+
+TEST(SOAContainerDefaultInit, Vector)
+{
+    testAppendUninitialized<
+            SOA::Container<std::vector, DefaultInitFields::Skin> >();
+}
+
+TEST(SOAContainerDefaultInit, Deque)
+{
+    testAppendUninitialized<
+            SOA::Container<std::deque, DefaultInitFields::Skin> >();
+}
+
+TEST(SOAContainerDefaultInit, Slab)
+{
+    testAppendUninitialized<
+            SOA::Container<SOA::SlabStorage, DefaultInitFields::Skin> >();
+}
+
+TEST(SOAContainerDefaultInit, AoSoA)
+{
+    testAppendUninitialized<
+            SOA::Container<SOA::AoSoA<8>::storage, DefaultInitFields::Skin> >();
+}
+
+/// memory of new elements is left alone
+TEST(SOAContainerDefaultInit, NoZeroing)
+{
+    SOA::Container<std::vector, DefaultInitFields::Skin> c;
+    for (int i = 0; i < 64; ++i) c.emplace_back(1.f, 17);
+    c.clear();
+    c.resize_default_init(64);
+    // the old contents are still there, i.e. nothing was zeroed
+    for (int i = 0; i < 64; ++i) EXPECT_EQ(17, c[i].n());
+    c.clear();
+    c.resize(64);
+    for (int i = 0; i < 64; ++i) EXPECT_EQ(0, c[i].n());
+}
+
+/* Copyright (C) CERN for the benefit of the LHCb collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In applying this licence, CERN does not waive the privileges and immunities
+ * granted to it by virtue of its status as an Intergovernmental Organization
+ * or submit itself to any jurisdiction.
+ */
+
+// vim: sw=4:tw=78:ft=cpp:et
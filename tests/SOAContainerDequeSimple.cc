@@ -15,6 +15,7 @@
 
 #include "gtest/gtest.h"
 #include "SOAContainer.h"
+#include "SOAAlgorithms.h"
 
 /// unit test Container class
 TEST(SOAContainerVectorSimple, IteratorsSizeEmpty)
@@ -344,6 +345,47 @@ TEST(SOAContainerVectorSimple, WithSTLAlgorithms)
     }
 }
 
+namespace DequeFields {
+    SOAFIELD_TRIVIAL(f_x, x, float);
+    SOAFIELD_TRIVIAL(f_d, d, double);
+    SOAFIELD_TRIVIAL(f_c, c, char);
+    SOASKIN_TRIVIAL(Skin, f_x, f_d, f_c);
+    SOAFIELD_TRIVIAL(f_sum, sum, double);
+} // namespace DequeFields
+
+TEST(SOAContainerDequeSimple, ForEachTransform)
+{
+    using namespace DequeFields;
+    SOA::Container<std::deque, Skin> c;
+    // columns of different element size have blocks of different length,
+    // and erasing at the front makes the runs start in mid-block
+    for (int i = -333; i < 5000; ++i) c.emplace_back(i, 2. * i, char(i));
+    c.erase(c.begin(), c.begin() + 333);
+#if defined(__GLIBCXX__)
+    static_assert(SOA::impl::is_segmented_iterator<
+                          decltype(c.begin<f_x>())>::value,
+                  "deque iterators should be segmented");
+#endif
+    SOA::for_each(c, [](SOA::ref<f_x> x, SOA::ref<f_d> d,
+                        SOA::cref<f_c> ch) {
+        x += 1;
+        d -= char(ch);
+    });
+    struct Sum {
+        SOA::value<f_sum> operator()(SOA::cref<f_x> x,
+                                     SOA::cref<f_d> d) const
+        { return x + d; }
+    };
+    const auto s = SOA::transform(c, Sum());
+    ASSERT_EQ(c.size(), s.size());
+    for (std::size_t k = 0; k < c.size(); ++k) {
+        const int i = int(k);
+        EXPECT_EQ(float(i + 1), c[k].x());
+        EXPECT_EQ(2. * i - char(i), c[k].d());
+        EXPECT_EQ(c[k].x() + c[k].d(), s[k].sum());
+    }
+}
+
 /* Copyright (C) CERN for the benefit of the LHCb collaboration
  *
  * This program is free software: you can redistribute it and/or modify
@@ -352,6 +352,50 @@ TEST(SOAContainerVectorSimple, WithSTLAlgorithms)
     }
 }
 
+/// all columns grow together, by a configurable factor
+TEST(SOAContainerVectorSimple, Growth)
+{
+    SOA::Container<std::vector, SOA::NullSkin, double, int, int> c;
+    EXPECT_EQ(2., c.growth_factor());
+    EXPECT_THROW(c.set_growth_factor(1.), std::invalid_argument);
+    c.set_growth_factor(1.5);
+    EXPECT_EQ(1.5, c.growth_factor());
+    c.reserve(100);
+    std::size_t oldcap = c.capacity(), nrealloc = 0;
+    for (int i = 0; i < 10000; ++i) {
+        c.emplace_back(i, i, -i);
+        if (c.capacity() == oldcap) continue;
+        ++nrealloc;
+        // one step for all columns, by the requested factor
+        EXPECT_EQ(std::size_t(oldcap * 1.5), c.capacity());
+        oldcap = c.capacity();
+    }
+    EXPECT_GE(12u, nrealloc);
+    // copies and swaps keep the capacity bookkeeping consistent
+    decltype(c) d(c);
+    EXPECT_EQ(1.5, d.growth_factor());
+    d.push_back(std::make_tuple(1., 2, 3));
+    EXPECT_EQ(10001u, d.size());
+    decltype(c) e;
+    swap(e, d);
+    EXPECT_EQ(1.5, e.growth_factor());
+    EXPECT_EQ(2., d.growth_factor());
+    EXPECT_TRUE(d.empty());
+    for (int i = 0; i < 100; ++i) d.emplace_back(i, i, i);
+    EXPECT_EQ(std::make_tuple(1., 2, 3), e.back());
+    // capacity gained by resize or insert is seen by the next append
+    decltype(c) f;
+    f.resize(1000);
+    EXPECT_EQ(1000u, f.capacity());
+    f.push_back(std::make_tuple(1., 2, 3));
+    EXPECT_EQ(2000u, f.capacity());
+    f.clear();
+    f.shrink_to_fit();
+    f.insert(f.begin(), 10, std::make_tuple(1., 2, 3));
+    f.push_back(std::make_tuple(1., 2, 3));
+    EXPECT_EQ(20u, f.capacity());
+}
+
 /* Copyright (C) CERN for the benefit of the LHCb collaboration
  *
  * This program is free software: you can redistribute it and/or modify
@@ -0,0 +1,108 @@
+/** @file tests/SOAFilterView.cc
+ *
+ * @brief test SOA::filter_view
+ *
+ * For copyright and license information, see the end of the file.
+ */
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "SOAFilterView.h"
+#include "SOAAoSoAStorage.h"
+
+namespace FilterFields {
+    SOAFIELD_TRIVIAL(f_x, x, float);
+    SOAFIELD_TRIVIAL(f_y, y, float);
+    SOAFIELD_TRIVIAL(f_n, n, int);
+    SOASKIN_TRIVIAL(Skin, f_x, f_y, f_n);
+} // namespace FilterFields
+
+template <typename CONT>
+static void testFilterView()
+{
+    using namespace FilterFields;
+    CONT c;
+    for (int i = 0; i < 100; ++i) c.emplace_back(i, -i, i % 10);
+    // predicate
+    auto even = SOA::filter_view(c, [](SOA::cref<f_x> x) {
+        return 0 == int(x) % 2;
+    });
+    EXPECT_EQ(50u, even.size());
+    for (std::size_t i = 0; i < even.size(); ++i) {
+        EXPECT_EQ(float(2 * i), even[i].x());
+        EXPECT_EQ(-float(2 * i), even[i].y());
+        EXPECT_EQ(int(2 * i) % 10, even[i].template get<f_n>());
+    }
+    // chain of cuts refers to the underlying container directly
+    auto cut = SOA::filter_view(even, [](SOA::cref<f_n> n) {
+        return n < 4;
+    });
+    static_assert(std::is_same<decltype(even), decltype(cut)>::value,
+                  "filtering a filtered view should not nest");
+    EXPECT_EQ(20u, cut.size());
+    EXPECT_EQ(cut.size(), cut.selection().size());
+    for (std::size_t i = 0; i < cut.size(); ++i) {
+        EXPECT_EQ(0, int(cut[i].x()) % 2);
+        EXPECT_GT(4, cut[i].n());
+        EXPECT_EQ(float(cut.selection()[i]), cut[i].x());
+    }
+    // writing through the view modifies the container
+    for (auto el : cut) el.y() = 42.f;
+    SOA::for_each(cut, [](SOA::ref<f_x> x) { x = -1.f; });
+    for (int i = 0; i < 100; ++i) {
+        const bool sel = 0 == i % 2 && (i % 10) < 4;
+        EXPECT_EQ(sel ? 42.f : -float(i), c[i].y());
+        EXPECT_EQ(sel ? -1.f : float(i), c[i].x());
+    }
+    // explicit selection vector, and iterating
+    auto some = SOA::filter_view(c, std::vector<std::size_t>{ 7, 3, 5 });
+    EXPECT_EQ(3u, some.size());
+    int expected[] = { 7, 3, 5 };
+    int k = 0;
+    for (auto el : some) EXPECT_EQ(expected[k++] % 10, el.n());
+    EXPECT_EQ(7, some.front().n());
+    EXPECT_EQ(5, some.back().n());
+    // mask
+    std::vector<bool> mask(c.size(), false);
+    mask[1] = mask[98] = true;
+    auto masked = SOA::filter_view(c, mask);
+    EXPECT_EQ(2u, masked.size());
+    EXPECT_EQ(1, masked[0].n());
+    EXPECT_EQ(8, masked[1].n());
+    // read-only filtered view of a const container
+    const CONT& cc = c;
+    auto none = SOA::filter_view(cc, [](int n) { return n > 9; });
+    EXPECT_TRUE(none.empty());
+}
+
+TEST(SOAFilterView, Vector)
+{ testFilterView<SOA::Container<std::vector, FilterFields::Skin> >(); }
+
+TEST(SOAFilterView, AoSoA)
+{
+    testFilterView<
+            SOA::Container<SOA::AoSoA<8>::storage, FilterFields::Skin> >();
+}
+
+/* Copyright (C) CERN for the benefit of the LHCb collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In applying this licence, CERN does not waive the privileges and immunities
+ * granted to it by virtue of its status as an Intergovernmental Organization
+ * or submit itself to any jurisdiction.
+ */
+
+// vim: sw=4:tw=78:ft=cpp:et
@@ -0,0 +1,273 @@
+/** @file tests/SOAParallel.cc
+ *
+ * @brief test multi-threaded SOA::for_each and SOA::transform
+ *
+ * For copyright and license information, see the end of the file.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "SOAParallel.h"
+#include "SOAAoSoAStorage.h"
+
+namespace ParFields {
+    SOAFIELD_TRIVIAL(f_x, x, float);
+    SOAFIELD_TRIVIAL(f_y, y, float);
+    SOAFIELD_TRIVIAL(f_n, n, int);
+    SOASKIN_TRIVIAL(Skin, f_x, f_y, f_n);
+    SOAFIELD_TRIVIAL(f_sum, sum, float);
+    SOAFIELD_TRIVIAL(f_i, i, int);
+} // namespace ParFields
+
+template <typename CONT>
+static void testParallel(std::size_t n, unsigned nthreads,
+                         std::size_t chunk)
+{
+    using namespace ParFields;
+    CONT c;
+    for (std::size_t i = 0; i < n; ++i) c.emplace_back(i, 2.f * i, int(i));
+    std::atomic<std::size_t> calls(0);
+    SOA::for_each(SOA::par(nthreads, chunk), c,
+                  [&calls](SOA::ref<f_x> x, SOA::cref<f_y> y) {
+                      ++calls;
+                      x += float(y);
+                  });
+    EXPECT_EQ(n, calls.load());
+    for (std::size_t i = 0; i < n; ++i) {
+        EXPECT_EQ(3.f * i, c[i].x());
+        EXPECT_EQ(2.f * i, c[i].y());
+    }
+    const auto t = SOA::transform(
+            SOA::par(nthreads, chunk), c,
+            [](SOA::cref<f_x> x, SOA::cref<f_y> y, SOA::cref<f_n> nn) {
+                return std::make_tuple(SOA::value<f_sum>(x + y),
+                                       SOA::value<f_i>(nn));
+            });
+    ASSERT_EQ(n, t.size());
+    for (std::size_t i = 0; i < n; ++i) {
+        EXPECT_EQ(5.f * i, t[i].sum());
+        EXPECT_EQ(int(i), t[i].i());
+    }
+}
+
+TEST(SOAParallel, Vector)
+{
+    using C = SOA::Container<std::vector, ParFields::Skin>;
+    testParallel<C>(0, 4, 0);
+    testParallel<C>(100, 4, 0);
+    testParallel<C>(10000, 4, 64);
+    testParallel<C>(10001, 3, 100);
+    testParallel<C>(5000, 1, 0);
+    testParallel<C>(5000, 0, 0);
+}
+
+TEST(SOAParallel, Deque)
+{
+    using C = SOA::Container<std::deque, ParFields::Skin>;
+    testParallel<C>(10001, 4, 64);
+}
+
+TEST(SOAParallel, AoSoA)
+{
+    using C = SOA::Container<SOA::AoSoA<16>::storage, ParFields::Skin>;
+    testParallel<C>(10001, 4, 64);
+}
+
+/// column container with the standard allocator
+template <typename T>
+using plainvec = std::vector<T>;
+
+TEST(SOAParallel, StdAllocatorOutput)
+{
+    using namespace ParFields;
+    SOA::Container<std::vector, Skin> c;
+    for (int i = 0; i < 10000; ++i) c.emplace_back(float(i), 0.f, i);
+    const auto t = SOA::transform<SOA::impl_algs::DefaultSkin, plainvec>(
+            SOA::par(4, 64), c, [](SOA::cref<f_x> x) {
+                return std::make_tuple(SOA::value<f_sum>(x + 1));
+            });
+    ASSERT_EQ(c.size(), t.size());
+    for (int i = 0; i < 10000; ++i) EXPECT_EQ(i + 1.f, t[i].sum());
+}
+
+TEST(SOAParallel, TransformReduce)
+{
+    using namespace ParFields;
+    SOA::Container<std::vector, Skin> c;
+    struct Sum {
+        float operator()(SOA::cref<f_x> x) const { return x; }
+    };
+    EXPECT_EQ(1.f, SOA::transform_reduce(SOA::par(4), c, 1.f,
+                                         std::plus<float>(), Sum()));
+    for (int i = 0; i < 100001; ++i) c.emplace_back(1.f / (1 + i), 0.f, i);
+    // same chunks: same result, whatever the number of threads
+    const float r1 = SOA::transform_reduce(SOA::par(1, 256), c, 0.f,
+                                           std::plus<float>(), Sum());
+    for (unsigned nthreads : {2u, 3u, 8u}) {
+        EXPECT_EQ(r1, SOA::transform_reduce(SOA::par(nthreads, 256), c,
+                                            0.f, std::plus<float>(),
+                                            Sum()));
+    }
+    EXPECT_NEAR(SOA::transform_reduce(c, 0.f, std::plus<float>(), Sum()),
+                r1, 1e-4f * r1);
+    struct Count {
+        std::tuple<long, long> operator()(SOA::cref<f_n> n) const
+        { return std::make_tuple(1l, long(n)); }
+    };
+    const auto r2 = SOA::transform_reduce(
+            SOA::par(4, 64), c, std::make_tuple(0l, 0l),
+            SOA::elementwise_plus(), Count());
+    EXPECT_EQ(100001l, std::get<0>(r2));
+    EXPECT_EQ(100001l * 100000l / 2, std::get<1>(r2));
+}
+
+TEST(SOAParallel, TransformReduceReproducible)
+{
+    using namespace ParFields;
+    SOA::Container<std::vector, Skin> c;
+    for (int i = 0; i < 1000000; ++i) c.emplace_back(0.1f, 0.f, i);
+    struct Sum {
+        float operator()(SOA::cref<f_x> x) const { return x; }
+    };
+    const float r1 = SOA::transform_reduce(SOA::par_reproducible(1), c, 0.f,
+                                           std::plus<float>(), Sum());
+    for (unsigned nthreads : {0u, 2u, 3u, 7u, 16u}) {
+        EXPECT_EQ(r1, SOA::transform_reduce(SOA::par_reproducible(nthreads),
+                                            c, 0.f, std::plus<float>(),
+                                            Sum()));
+    }
+    // pairwise summation: accurate to a few ulps
+    EXPECT_NEAR(1e5f, r1, 0.05f);
+}
+
+TEST(SOAParallel, ForEachUniquePair)
+{
+    using namespace ParFields;
+    using C = SOA::Container<std::vector, Skin>;
+    for (int n : {0, 1, 2, 17, 100, 1000, 2001}) {
+        for (unsigned nthreads : {1u, 3u, 4u}) {
+            C c;
+            for (int i = 0; i < n; ++i) c.emplace_back(0.f, 0.f, i);
+            std::vector<int> cnt(std::size_t(n) * n, 0);
+            SOA::for_each_unique_pair(
+                    SOA::par(nthreads), c,
+                    [&cnt, n](C::reference a, C::reference b) {
+                        ++cnt[std::size_t(a.n()) * n + std::size_t(b.n())];
+                        a.x() += b.n() - a.n();
+                        b.x() -= b.n() - a.n();
+                        a.y() += 1;
+                        b.y() += 1;
+                    });
+            EXPECT_EQ(std::size_t(n) * (n - 1) / 2,
+                      std::size_t(std::count(cnt.begin(), cnt.end(), 1)));
+            for (int i = 0; i < n; ++i) {
+                EXPECT_EQ(float(n * (n - 1) / 2 - n * i), c[i].x());
+                EXPECT_EQ(float(n - 1), c[i].y());
+            }
+        }
+    }
+}
+
+namespace {
+    /// pair interaction with non-integer updates, picking fields
+    struct PairKick {
+        void operator()(SOA::ref<ParFields::f_x> xa,
+                        SOA::cref<ParFields::f_y> ya,
+                        SOA::ref<ParFields::f_x> xb,
+                        SOA::cref<ParFields::f_y> yb) const
+        {
+            const float dy = float(yb) - float(ya);
+            const float d = 0.37f * dy / (1.f + dy * dy);
+            xa += d;
+            xb -= d;
+        }
+    };
+
+    /// bit patterns of the x field of a container
+    template <typename C>
+    std::vector<std::uint32_t> xbits(const C& c)
+    {
+        std::vector<std::uint32_t> retVal(c.size());
+        for (std::size_t i = 0; i < c.size(); ++i) {
+            const float x = c[i].x();
+            std::memcpy(&retVal[i], &x, sizeof(x));
+        }
+        return retVal;
+    }
+} // namespace
+
+TEST(SOAParallel, ForEachUniquePairReproducible)
+{
+    using namespace ParFields;
+    using C = SOA::Container<std::vector, Skin>;
+    for (int n : {100, 1000, 2001}) {
+        std::vector<std::uint32_t> ref1, ref2;
+        for (unsigned nthreads : {1u, 2u, 3u, 4u, 7u}) {
+            C c1, c2;
+            for (int i = 0; i < n; ++i) {
+                c1.emplace_back(0.f, std::sin(0.1f * i), i);
+                c2.emplace_back(0.f, std::sin(0.1f * i), i);
+            }
+            SOA::for_each_unique_pair(SOA::par(nthreads), c1, PairKick());
+            SOA::for_each_unique_pair(
+                    SOA::par(nthreads), c2,
+                    [](C::reference a, C::reference b) {
+                        const float dy = b.y() - a.y();
+                        const float d = 0.37f * dy / (1.f + dy * dy);
+                        a.x() += d;
+                        b.x() -= d;
+                    });
+            if (1u == nthreads) {
+                ref1 = xbits(c1);
+                ref2 = xbits(c2);
+                continue;
+            }
+            EXPECT_EQ(ref1, xbits(c1));
+            EXPECT_EQ(ref2, xbits(c2));
+        }
+    }
+}
+
+TEST(SOAParallel, Exception)
+{
+    using namespace ParFields;
+    SOA::Container<std::vector, Skin> c;
+    for (int i = 0; i < 10000; ++i) c.emplace_back(0.f, 0.f, i);
+    EXPECT_THROW(SOA::for_each(SOA::par(4, 64), c,
+                               [](SOA::cref<f_n> nn) {
+                                   if (5000 == nn)
+                                       throw std::runtime_error("oops");
+                               }),
+                 std::runtime_error);
+}
+
+/* Copyright (C) CERN for the benefit of the LHCb collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In applying this licence, CERN does not waive the privileges and immunities
+ * granted to it by virtue of its status as an Intergovernmental Organization
+ * or submit itself to any jurisdiction.
+ */
+
+// vim: sw=4:tw=78:ft=cpp:et
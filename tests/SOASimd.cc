@@ -0,0 +1,133 @@
+/** @file tests/SOASimd.cc
+ *
+ * @brief test SOA::for_each_simd and SOA::pack
+ *
+ * For copyright and license information, see the end of the file.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "SOASimd.h"
+#include "SOAAoSoAStorage.h"
+
+namespace SimdFields {
+    SOAFIELD_TRIVIAL(f_x, x, float);
+    SOAFIELD_TRIVIAL(f_y, y, float);
+    SOAFIELD_TRIVIAL(f_n, n, int);
+    SOASKIN_TRIVIAL(Skin, f_x, f_y, f_n);
+} // namespace SimdFields
+
+TEST(SOASimd, Vec)
+{
+    using V = SOA::simd::vec<float, 4>;
+    static_assert(16 == alignof(V), "vec should be naturally aligned");
+    V a = V::broadcast(2.f), b = V::broadcast(3.f);
+    b[3] = -1.f;
+    const V c = -(a * b + 1.f) / 2.f;
+    EXPECT_EQ(-3.5f, c[0]);
+    EXPECT_EQ(0.5f, c[3]);
+    EXPECT_EQ(-1.f, SOA::simd::min(a, b)[3]);
+    EXPECT_EQ(3.f, SOA::simd::max(a, b)[0]);
+    EXPECT_EQ(2.f, SOA::simd::sqrt(V::broadcast(4.f))[1]);
+    EXPECT_EQ(8.f, SOA::simd::reduce_add(a));
+    EXPECT_EQ(4.f, SOA::simd::reduce_add(a, 2));
+    EXPECT_EQ(0.f, SOA::simd::reduce_add(a, 0));
+}
+
+template <typename CONT>
+static void testForEachSimd(std::size_t n)
+{
+    using namespace SimdFields;
+    CONT c;
+    for (std::size_t i = 0; i < n; ++i) c.emplace_back(i, 3.f * i, -int(i));
+    std::size_t calls = 0;
+    SOA::for_each_simd<8>(c, [&calls](SOA::pack<f_x, 8>& x,
+                                      const SOA::pack<f_y, 8>& y,
+                                      SOA::pack<f_n, 8> nn) {
+        ++calls;
+        x = SOA::simd::sqrt(x * x + y * y);
+        // read-only: not written back
+        nn += 1;
+    });
+    EXPECT_EQ((n + 7) / 8, calls);
+    for (std::size_t i = 0; i < n; ++i) {
+        EXPECT_FLOAT_EQ(std::sqrt(10.f) * i, c[i].x());
+        EXPECT_EQ(3.f * i, c[i].y());
+        EXPECT_EQ(-int(i), c[i].n());
+    }
+}
+
+TEST(SOASimd, ForEachSimdVector)
+{
+    using C = SOA::Container<std::vector, SimdFields::Skin>;
+    testForEachSimd<C>(64);
+    testForEachSimd<C>(67);
+    testForEachSimd<C>(5);
+    testForEachSimd<C>(0);
+}
+
+TEST(SOASimd, ForEachSimdAoSoA)
+{
+    using C = SOA::Container<SOA::AoSoA<8>::storage, SimdFields::Skin>;
+    testForEachSimd<C>(64);
+    testForEachSimd<C>(67);
+}
+
+/// padded lanes in the remainder are copies of the last valid element
+TEST(SOASimd, Remainder)
+{
+    using namespace SimdFields;
+    SOA::Container<std::vector, Skin> c;
+    for (int i = 0; i < 11; ++i) c.emplace_back(i, 0.f, 0);
+    std::vector<float> seen;
+    SOA::for_each_simd<4>(c, [&seen](const SOA::pack<f_x, 4>& x) {
+        for (std::size_t i = 0; i < 4; ++i) seen.push_back(x[i]);
+    });
+    ASSERT_EQ(12u, seen.size());
+    EXPECT_EQ(10.f, seen[10]);
+    EXPECT_EQ(10.f, seen[11]);
+}
+
+/// reductions over a partial last pack only see the valid lanes
+TEST(SOASimd, ReduceTail)
+{
+    using namespace SimdFields;
+    SOA::Container<std::vector, Skin> c;
+    for (int i = 0; i < 10; ++i) c.emplace_back(1.f, 0.25f * i, 0);
+    float sum = 0, sumy = 0;
+    std::vector<std::size_t> lanes;
+    SOA::for_each_simd<8>(c, [&](const SOA::pack<f_x, 8>& x,
+                                 const SOA::pack<f_y, 8>& y) {
+        lanes.push_back(x.lanes());
+        EXPECT_EQ(x.lanes(), y.lanes());
+        sum += SOA::simd::reduce_add(x, x.lanes());
+        sumy += SOA::simd::reduce_add(x * y, y.lanes());
+    });
+    EXPECT_EQ(10.f, sum);
+    EXPECT_EQ(0.25f * 45, sumy);
+    EXPECT_EQ(std::vector<std::size_t>({8, 2}), lanes);
+}
+
+/* Copyright (C) CERN for the benefit of the LHCb collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In applying this licence, CERN does not waive the privileges and immunities
+ * granted to it by virtue of its status as an Intergovernmental Organization
+ * or submit itself to any jurisdiction.
+ */
+
+// vim: sw=4:tw=78:ft=cpp:et